@@ -1,33 +1,50 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
 #include <filesystem>
 #include <functional>
+#include <future>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 #include <vector>
 
 #include "internal/error.hpp"
+#include "internal/pool.hpp"
+#ifdef CLIXX_METRICS
+#include "internal/metrics.hpp"
+#endif
+#include "internal/search.hpp"
+#include "internal/strings.hpp"
 #include "internal/target.hpp"
 #include "internal/writer.hpp"
 
 namespace cli {
 
 class command;
+struct command_tree;
 
+// flag strings are interned (see string_pool), copying a flag does not
+// allocate
 struct flag {
     target t;
-    std::string name;
-    std::string letters;
-    std::string sample;
-    std::string desc;
+    std::string_view name;
+    std::string_view letters;
+    std::string_view sample;
+    std::string_view desc;
 
-    flag(target const& t, std::string const& name, std::string const& letters,
-        std::string const& desc, std::string const& sample = {})
+    flag(target const& t, std::string_view name, std::string_view letters,
+        std::string_view desc, std::string_view sample = {})
         : t{t}
-        , name{name}
-        , letters{letters}
-        , desc{desc}
-        , sample{sample}
+        , name{internal::names().intern(name)}
+        , letters{internal::names().intern(letters)}
+        , sample{internal::names().intern(sample)}
+        , desc{internal::descriptions().intern(desc)}
     {
     }
 
@@ -40,6 +57,8 @@ struct flag {
             ret += sample;
             ret += ">";
         }
+        else if (auto c = t.choices(); show_samples && c)
+            ret += "=<" + c->allowed() + ">";
         if (t.is_vector())
             ret += "...";
         return ret;
@@ -49,25 +68,18 @@ struct flag {
     {
 
         if (!name.empty() && (prefer_long || letters.empty()))
-            return std::string("--") + name;
+            return std::string("--") + std::string{name};
         if (!letters.empty())
             return std::string("-") + letters[0];
         else
             return "#EMPTY#";
     }
 
-    auto used() const -> bool { return !used_as.empty(); }
+    auto used() const -> bool { return in_use; }
 
 protected:
-    std::string used_as;
+    bool in_use = false;
 
-    auto name_match(std::string_view s, bool as_letter) -> bool
-    {
-        if (!as_letter)
-            return s == name;
-        else
-            return s.size() == 1 && letters.find(s[0]) != std::string::npos;
-    }
     friend class command;
     friend struct flag_list;
 };
@@ -90,21 +102,28 @@ struct flag_list {
 
     auto syntax(bool show_samples = true) const -> std::vector<std::string>;
 
+    // clears the 'used' state of all flags and the values recorded by
+    // deferred targets
+    void reset();
+
 protected:
-    auto find(std::string_view s, bool as_letter) -> flag*;
     auto validate() -> bool;
+    void finish();
+    void collect_paths(std::vector<path_list const*>& targets) const;
     friend class command;
 };
 
 // defines a stand-alone argument (not a flag)
 struct argument {
     target t;
-    std::string name;
-    std::string desc;
+    std::string_view name;
+    std::string_view desc;
 
     auto syntax() const -> std::string
     {
-        auto ret = name;
+        auto ret = std::string{name};
+        if (t.is_passthrough())
+            ret = std::string("-- ") + ret + "...";
         if (t.is_vector())
             ret += "...";
         if (!t.required)
@@ -113,10 +132,10 @@ struct argument {
     }
 
 protected:
-    argument(target const& t, std::string const& name, std::string const& desc)
+    argument(target const& t, std::string_view name, std::string_view desc)
         : t{t}
-        , name{name}
-        , desc{desc}
+        , name{internal::names().intern(name)}
+        , desc{internal::descriptions().intern(desc)}
     {
     }
 
@@ -128,28 +147,82 @@ class command {
 public:
     using subcmd_callback = std::function<void(command& cmd)>;
 
+    // completion reports the outcome of an asynchronous action or of an
+    // asynchronous execution, nullptr on success
+    using completion = std::function<void(std::exception_ptr err)>;
+
     flag_list flags;
     std::vector<argument> arguments;
     std::function<void()> action;
 
+    // async_action is used instead of action for commands that wait on I/O,
+    // it must invoke the completion exactly once (possibly from another thread)
+    std::function<void(completion done)> async_action;
+
     auto subcommand(std::string const& name, std::string const& desc, subcmd_callback callback)
     {
         subcommands.push_back(subcmd{name, desc, callback});
     }
 
-    void flag(target const& t, std::string const& name, std::string const& letters,
-        std::string const& desc, std::string const& sample = {})
+    void flag(target const& t, std::string_view name, std::string_view letters,
+        std::string_view desc, std::string_view sample = {})
     {
         flags.items.push_back(cli::flag{t, name, letters, desc, sample});
+        index.clear();
     }
 
     // todo: add function that constructs flag lists
 
-    void arg(target const& t, std::string const& name, std::string const& desc)
+    void arg(target const& t, std::string_view name, std::string_view desc)
     {
         arguments.push_back(argument{t, name, desc});
     }
 
+    // make creates a value owned by this command, used instead of static
+    // targets when several apps run concurrently (see batch)
+    template <typename T, typename... Args> auto make(Args&&... args) -> T&
+    {
+        auto p = std::make_shared<T>(std::forward<Args>(args)...);
+        owned.push_back(p);
+        return *p;
+    }
+
+    // walk builds every node of the command tree and calls the visitor for
+    // this command and each of its subcommands (depth-first, in declaration
+    // order); subcommand nodes and their parents are alive during the call
+    using visitor =
+        std::function<void(command const& cmd, std::string const& path, std::string const& desc)>;
+    void walk(visitor const& v, std::string const& path = {}, std::string const& desc = {});
+
+    // builds every node of the command tree, the tree refers to this command
+    auto build_tree() -> command_tree;
+
+    // machine-readable (JSON) description of this command
+    auto schema(std::string const& path, std::string const& desc) const -> std::string;
+
+    // memory held by this command node (excluding its subcommand nodes)
+    struct footprint {
+        std::string path;
+        size_t name_bytes = 0;     // names, letters, and samples
+        size_t desc_bytes = 0;     // descriptions
+        size_t target_bytes = 0;   // flag, argument, and flag group records
+        size_t children_bytes = 0; // subcommand records and callbacks
+        size_t subtree_bytes = 0;  // this node and all of its subcommand nodes
+        std::chrono::nanoseconds build_time{};   // spent in the subcmd_callback
+        std::chrono::nanoseconds subtree_time{}; // building the whole subtree
+
+        auto bytes() const -> size_t
+        {
+            return name_bytes + desc_bytes + target_bytes + children_bytes;
+        }
+    };
+
+    auto measure() const -> footprint;
+
+    // renders usage information for this command
+    auto usage(std::string const& exe_prefix, std::string const& cmd_prefix,
+        std::string const& desc, std::string const& help_cmd) const -> std::string;
+
 protected:
     struct subcmd {
         std::string name;
@@ -159,15 +232,99 @@ protected:
 
     std::vector<subcmd> subcommands;
     command* parent_cmd = nullptr; // link to a parent command
+    std::vector<std::shared_ptr<void>> owned; // see make()
+
+    // original argv (if available) that backs the root's string_views,
+    // used for zero-copy passthrough arguments
+    char* const* raw_argv = nullptr;
+    std::string_view const* raw_first = nullptr;
+
+    // metrics state is declared unconditionally, so that the layout of
+    // command does not depend on CLIXX_METRICS (translation units may differ)
+    std::string metrics_path; // subcommand path used as a metrics label
+    std::chrono::steady_clock::time_point parse_start;
+
+    // usage counters, no-ops unless compiled with CLIXX_METRICS
+    void count_command();
+    void count_flag(cli::flag const* f);
+    void count_parse();
+
+    void exec(std::string_view const* first, std::string_view const* last,
+        completion const* done = nullptr);
+
+    // flag_index is a dense lookup table over the flags of a command, built
+    // on first lookup: name hashes and flags are kept in parallel arrays,
+    // single-letter forms are resolved through a byte-indexed table that is
+    // only allocated for commands with single-letter flags. The index only
+    // serves lookups, validation and usage still walk the flag_list tree.
+    struct flag_index {
+        using letter_table = std::array<uint16_t, 256>; // index + 1, zero when unused
+
+        std::vector<uint32_t> hashes;
+        std::vector<cli::flag*> flags;
+        std::unique_ptr<letter_table> letters;
+        bool built = false;
+
+        flag_index() = default;
+        // pointers refer to the flags of the source, rebuild on demand
+        flag_index(flag_index const&) {}
+        auto operator=(flag_index const&) -> flag_index&
+        {
+            clear();
+            return *this;
+        }
+
+        void clear()
+        {
+            hashes.clear();
+            flags.clear();
+            letters.reset();
+            built = false;
+        }
 
-    void exec(std::string_view const* first, std::string_view const* last);
+        void build(flag_list& fl)
+        {
+            for (auto& it : fl.items)
+                if (auto v = std::get_if<flag_list>(&it))
+                    build(*v);
+                else if (auto f = std::get_if<cli::flag>(&it)) {
+                    hashes.push_back(internal::name_hash(f->name));
+                    flags.push_back(f);
+                    if (!f->letters.empty() && !letters)
+                        letters = std::make_unique<letter_table>();
+                    for (auto c : f->letters)
+                        if (!(*letters)[uint8_t(c)] && flags.size() <= 0xffff)
+                            (*letters)[uint8_t(c)] = uint16_t(flags.size());
+                }
+            built = true;
+        }
+
+        auto find(std::string_view s, bool as_letter) -> cli::flag*
+        {
+            if (as_letter) {
+                if (s.size() != 1 || !letters)
+                    return nullptr;
+                auto i = (*letters)[uint8_t(s[0])];
+                return i ? flags[i - 1] : nullptr;
+            }
+            auto h = internal::name_hash(s);
+            for (size_t i = 0; i < hashes.size(); ++i)
+                if (hashes[i] == h && flags[i]->name == s)
+                    return flags[i];
+            return nullptr;
+        }
+    };
+
+    flag_index index;
 
     auto find_flag(std::string_view s, bool as_letter) -> cli::flag*
     {
         // find a flag in this command or in one of its parent commands
         auto cmd = this;
         while (cmd) {
-            auto ret = cmd->flags.find(s, as_letter);
+            if (!cmd->index.built)
+                cmd->index.build(cmd->flags);
+            auto ret = cmd->index.find(s, as_letter);
             if (ret)
                 return ret;
             cmd = cmd->parent_cmd;
@@ -183,10 +340,37 @@ protected:
         std::string_view const* first, // command line arguments
         std::string_view const* last) -> std::string;
 
-    auto usage(std::string const& exe_prefix, std::string const& cmd_prefix,
-        std::string const& desc, std::string const& help_cmd) const -> std::string;
+    void collect_arguments(std::string_view const* first, std::string_view const* last,
+        std::string_view const* tail_first = nullptr, std::string_view const* tail_last = nullptr);
+    void check_paths() const;
+    void finish_targets();
+
+    void build_tree(command_tree& tree, std::string const& path, std::string const& desc,
+        size_t parent, std::chrono::nanoseconds build_time);
+
+    friend class cursor;
+};
+
+// command_tree holds every node of a command tree in pre-order, each
+// subcommand node is built exactly once
+struct command_tree {
+    struct node {
+        std::string path; // subcommand path, empty for the root command
+        std::string desc;
+        command const* cmd;
+        size_t parent; // index of the parent node, npos for the root
+        std::chrono::nanoseconds build_time; // spent in the subcmd_callback
+    };
 
-    void collect_arguments(std::string_view const* first, std::string_view const* last);
+    std::vector<node> nodes;
+    std::vector<std::unique_ptr<command>> owned;
+};
+
+// static_help is an entry of a help table generated at build time (see
+// clixx_add_help_tables in CMakeLists.txt), tables are sorted by path
+struct static_help {
+    std::string_view path; // subcommand path, empty for the root command
+    std::string_view text;
 };
 
 // app is the root command
@@ -196,6 +380,12 @@ public:
     std::string desc;
     std::string help_cmd = {};
     std::string help_flag = "--help";
+    std::string search_flag = "--search"; // help --search <terms>
+
+    // search index is persisted next to the executable, build_id identifies
+    // the binary (its size and modification time are used when empty)
+    std::string build_id = {};
+    std::filesystem::path search_index_path = {};
 
     app(std::string const& desc)
         : name{}
@@ -209,7 +399,10 @@ public:
     {
     }
 
-    void execute(std::string_view const* first, std::string_view const* last);
+    void execute(std::string_view const* first, std::string_view const* last)
+    {
+        execute_raw(first, last, nullptr);
+    }
 
     void execute(std::initializer_list<std::string_view> cmdline)
     {
@@ -222,29 +415,273 @@ public:
         args.reserve(argc);
         for (auto i = 0; i < argc; ++i)
             args.push_back(argv[i]);
-        execute(args.data(), args.data() + args.size());
+        execute_raw(args.data(), args.data() + args.size(), argv);
     }
 
     void execute(int argc, wchar_t* argv[])
     {
         auto strings = std::vector<std::string>{};
         auto args = std::vector<std::string_view>{};
+        auto raw = std::vector<char*>{};
         args.reserve(argc);
         strings.reserve(argc);
+        raw.reserve(argc + 1);
         for (auto i = 0; i < argc; ++i) {
             // use filesystem::path for wide_string->string conversion
             // until something more appropriate is available
             auto conv = std::filesystem::path{argv[i]};
             strings.push_back(conv.string());
             args.push_back(strings.back());
+            raw.push_back(strings.back().data());
         }
-        execute(args.data(), args.data() + args.size());
+        raw.push_back(nullptr);
+        execute_raw(args.data(), args.data() + args.size(), raw.data());
+    }
+
+    // executor posts a task for execution (an event loop, a thread pool, etc.)
+    using executor = std::function<void(std::function<void()> task)>;
+
+    // execute_async parses the command line and dispatches the action on the
+    // executor, the outcome of both parsing and the action (including
+    // cli::help and cli::error) is reported through the completion. The app
+    // and the targets must outlive the completion.
+    void execute_async(std::vector<std::string> cmdline, executor const& ex, completion done);
+
+    auto execute_async(std::vector<std::string> cmdline, executor const& ex)
+        -> std::future<void>
+    {
+        auto p = std::make_shared<std::promise<void>>();
+        auto f = p->get_future();
+        execute_async(std::move(cmdline), ex, [p](std::exception_ptr err) {
+            if (err)
+                p->set_exception(err);
+            else
+                p->set_value();
+        });
+        return f;
     }
 
     auto exe_path() const -> const std::filesystem::path& { return executable_path; }
 
+    // builds the search index by walking the whole command tree
+    auto build_search_index() -> cli::search_index;
+
+    // loads the persisted search index, or builds and persists a new one
+    auto load_search_index() -> cli::search_index;
+
+    // returns ranked search results formatted for printing
+    auto search(std::string_view terms) -> std::string;
+
+    // serves help requests from a table generated at build time, the
+    // command tree is not built and no formatting is done at runtime
+    template <size_t N> void use_help_table(static_help const (&table)[N])
+    {
+        help_table = table;
+        help_table_size = N;
+    }
+
+    // renders help messages for every node of the command tree, sorted by
+    // path (this is what the build-time generator embeds)
+    auto help_pages(unsigned nthreads = 0) -> std::vector<std::pair<std::string, std::string>>;
+
+    struct doc_page {
+        std::string path;   // subcommand path, empty for the root command
+        std::string usage;  // help message
+        std::string schema; // JSON object
+    };
+
+    // documents every node of the command tree: the tree is built once,
+    // pages are rendered in parallel on a work-stealing pool (nthreads = 0
+    // uses all cores) and returned in pre-order
+    auto document(unsigned nthreads = 0) -> std::vector<doc_page>;
+
+    // JSON array with the schemas of all nodes in pre-order
+    auto export_schema(unsigned nthreads = 0) -> std::string;
+
+    // builds the whole command tree and measures every node, in pre-order
+    auto introspect() -> std::vector<footprint>;
+
+    // formats footprints sorted by subtree build time, then by subtree size;
+    // limit = 0 reports all nodes
+    static auto report(std::vector<footprint> nodes, size_t limit = 0) -> std::string;
+
 protected:
     std::filesystem::path executable_path; // obtained from the first command line parameter
+
+    // raw is the null-terminated array of strings that backs [first, last)
+    void execute_raw(std::string_view const* first, std::string_view const* last,
+        char* const* raw, completion const* done = nullptr);
+
+    auto index_location(std::string& id) const -> std::filesystem::path;
+
+    static_help const* help_table = nullptr;
+    size_t help_table_size = 0;
+
+    auto help_message(command const& cmd, std::string const& path,
+        std::string const& cmd_desc) const -> std::string;
+
+    auto help_command() const -> std::string const&
+    {
+        return help_cmd.empty() ? help_flag : help_cmd;
+    }
+    auto find_static_help(std::string_view const* first, std::string_view const* last) const
+        -> static_help const*;
+
+    friend class multicall;
+};
+
+// multicall dispatches a single (busybox-style) binary to one of the
+// registered tools, the tool is selected by the executable name or, when
+// the name does not match any tool, by the first argument: 'multi <tool> ...'
+class multicall {
+public:
+    using factory = std::function<void(app& a)>;
+
+    struct tool {
+        std::string name;
+        std::string desc;
+        factory setup;
+    };
+
+    static auto registry() -> std::vector<tool>&;
+    // throws std::logic_error when the name is already registered
+    static void add(std::string const& name, std::string const& desc, factory setup);
+    static auto find(std::string_view name) -> tool const*;
+    static auto list(std::string const& exe_prefix) -> std::string;
+
+    static void execute(std::string_view const* first, std::string_view const* last);
+
+    static void execute(std::initializer_list<std::string_view> cmdline)
+    {
+        execute(cmdline.begin(), cmdline.end());
+    }
+
+    static void execute(int argc, char* argv[]);
+    static void execute(int argc, wchar_t* argv[]);
+
+protected:
+    static void dispatch(
+        std::string_view const* first, std::string_view const* last, char* const* raw);
+};
+
+// register_tool is used for static registration of multicall tools:
+//
+//     static auto reg = cli::register_tool{"ls", "list files", [](cli::app& a) {...}};
+struct register_tool {
+    register_tool(std::string const& name, std::string const& desc, multicall::factory setup)
+    {
+        multicall::add(name, desc, setup);
+    }
+};
+
+// batch runs several invocations from a single command line, separated by a
+// token: 'tool check a , check b'. Each invocation gets a fresh app from the
+// factory, so parse state is never shared; targets should be created with
+// make() or captured by value. Results are reported in command line order.
+class batch {
+public:
+    // actions write their output to the stream, it is captured per invocation
+    using factory = std::function<void(app& a, std::ostream& out)>;
+
+    struct result {
+        std::vector<std::string> args; // without the executable name
+        int status = 0;                // 0 on success or help, 1 on error
+        std::string output;            // written by the action
+        std::string message;           // help or error message
+    };
+
+    std::string name;
+    std::string desc;
+    factory setup;
+    std::string separator = ",";
+    bool parallel = false; // run invocations concurrently on a thread pool
+    unsigned nthreads = 0; // 0 for hardware concurrency
+
+    batch(std::string const& name, std::string const& desc, factory setup)
+        : name{name}
+        , desc{desc}
+        , setup{std::move(setup)}
+    {
+    }
+
+    auto execute(std::string_view const* first, std::string_view const* last)
+        -> std::vector<result>;
+
+    auto execute(std::initializer_list<std::string_view> cmdline) -> std::vector<result>
+    {
+        return execute(cmdline.begin(), cmdline.end());
+    }
+
+    auto execute(int argc, char* argv[]) -> std::vector<result>;
+
+    // first non-zero status, 0 when all invocations succeeded
+    static auto status(std::vector<result> const& results) -> int;
+
+    // output and messages of all invocations, in command line order
+    static auto combined(std::vector<result> const& results) -> std::string;
+
+protected:
+    void run(std::string_view exe, result& r) const;
+};
+
+// cursor scans a command line incrementally for completion and interactive
+// line editing. The scan state after each token is cached, appending or
+// editing the last token resumes from the cached prefix. Subcommand nodes
+// are built once per cursor, flag targets are never written.
+class cursor {
+public:
+    // used_flags is a persistent list of flags used so far, states share
+    // their common tails
+    struct used_flags {
+        cli::flag const* f;
+        std::shared_ptr<used_flags const> next;
+    };
+
+    struct state {
+        command* node = nullptr;               // current command node
+        std::string path;                      // subcommand path
+        std::shared_ptr<used_flags const> used; // flags used so far
+        size_t positional = 0;                 // number of free-standing arguments
+        cli::flag const* pending = nullptr;    // flag that waits for its value
+        bool at_command = true;                // next token may be a subcommand
+        bool terminated = false;               // after '--'
+
+        auto is_used(cli::flag const* f) const -> bool
+        {
+            for (auto u = used.get(); u; u = u->next.get())
+                if (u->f == f)
+                    return true;
+            return false;
+        }
+    };
+
+    explicit cursor(app& root);
+
+    // update rescans the tokens (excluding the executable name) reusing the
+    // states of the common prefix with the previous update
+    void update(std::string_view const* first, std::string_view const* last);
+
+    void update(std::vector<std::string> const& tokens)
+    {
+        auto views = std::vector<std::string_view>{tokens.begin(), tokens.end()};
+        update(views.data(), views.data() + views.size());
+    }
+
+    // state after all tokens
+    auto current() const -> state const& { return states.back(); }
+
+    // completion candidates for a partially typed token that follows the
+    // scanned tokens
+    auto complete(std::string_view partial) const -> std::vector<std::string>;
+
+protected:
+    app& root;
+    std::vector<std::string> tokens;
+    std::vector<state> states; // states[i] is the state after i tokens
+    std::vector<std::pair<std::string, std::unique_ptr<command>>> nodes;
+
+    auto node(command* parent, std::string const& path, command::subcmd const& sub) -> command*;
+    auto step(state const& st, std::string_view tok) -> state;
 };
 
 namespace internal {
@@ -259,11 +696,35 @@ inline auto wrap_parenthesis(std::string const& s) -> std::string
     return std::string{"("} + s + ")";
 }
 
+inline auto json_string(std::string_view s) -> std::string
+{
+    auto ret = std::string{"\""};
+    for (auto c : s) {
+        switch (c) {
+        case '"': ret += "\\\""; break;
+        case '\\': ret += "\\\\"; break;
+        case '\n': ret += "\\n"; break;
+        case '\t': ret += "\\t"; break;
+        case '\r': ret += "\\r"; break;
+        default:
+            if ((unsigned char)(c) < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", unsigned(c));
+                ret += buf;
+            }
+            else
+                ret += c;
+        }
+    }
+    ret += '"';
+    return ret;
+}
+
 inline void desc(writer& w, flag const& f)
 {
     auto s = std::string{};
     if (!f.name.empty())
-        s = std::string("--") + f.name;
+        s = std::string("--") + std::string{f.name};
     for (auto& ltr : f.letters) {
         if (!s.empty())
             s += ' ';
@@ -326,21 +787,6 @@ inline auto flag_list::syntax(bool show_samples) const -> std::vector<std::strin
     return ret;
 }
 
-inline auto flag_list::find(std::string_view s, bool as_letter) -> flag*
-{
-    for (auto& it : items) {
-        if (auto fl = std::get_if<flag_list>(&it)) {
-            if (auto f = fl->find(s, as_letter))
-                return f;
-        }
-        else if (auto f = std::get_if<flag>(&it)) {
-            if (f->name_match(s, as_letter))
-                return f;
-        }
-    }
-    return nullptr;
-}
-
 inline auto flag_list::validate() -> bool
 {
     // returns true any of the contained flags is in use
@@ -401,6 +847,39 @@ inline auto flag_list::validate() -> bool
     return !used.empty();
 }
 
+inline void flag_list::reset()
+{
+    for (auto& it : items) {
+        if (auto fl = std::get_if<flag_list>(&it))
+            fl->reset();
+        else if (auto f = std::get_if<flag>(&it)) {
+            f->in_use = false;
+            f->t.reset();
+        }
+    }
+}
+
+inline void flag_list::finish()
+{
+    for (auto& it : items) {
+        if (auto fl = std::get_if<flag_list>(&it))
+            fl->finish();
+        else if (auto f = std::get_if<flag>(&it))
+            f->t.finish();
+    }
+}
+
+inline void flag_list::collect_paths(std::vector<path_list const*>& targets) const
+{
+    for (auto& it : items) {
+        if (auto fl = std::get_if<flag_list>(&it))
+            fl->collect_paths(targets);
+        else if (auto f = std::get_if<flag>(&it))
+            if (auto p = f->t.paths())
+                targets.push_back(p);
+    }
+}
+
 inline auto extract_short(std::string_view desc) -> std::string_view
 {
     auto nl = desc.find('\n');
@@ -474,7 +953,10 @@ inline auto command::usage(std::string const& exe_prefix, std::string const& cmd
     if (!arguments.empty()) {
         w.line("\narguments:");
         for (auto& arg : arguments)
-            w.cols({arg.name, arg.desc});
+            if (auto c = arg.t.choices())
+                w.cols({arg.name, std::string{arg.desc} + " (" + c->allowed() + ")"});
+            else
+                w.cols({arg.name, arg.desc});
         w.done_cols("    ", "  ");
     }
 
@@ -488,26 +970,60 @@ inline auto command::usage(std::string const& exe_prefix, std::string const& cmd
     return w.buf;
 }
 
-inline void command::exec(std::string_view const* first, std::string_view const* last)
+inline void command::exec(
+    std::string_view const* first, std::string_view const* last, completion const* done)
 {
     // arg_strings collects all free-standing arguments
     auto arg_strings = std::vector<std::string_view>{};
 
+    // targets may be shared between runs (static targets of subcommands)
+    flags.reset();
+    for (auto& arg : arguments)
+        arg.t.reset();
+
+    count_command();
+
     if (first != last) {
         // do we have a command?
         for (auto& sub : subcommands) {
             if (sub.name == *first) {
-                auto cmd = command{};
-                cmd.parent_cmd = this;
-                if (sub.callback)
-                    sub.callback(cmd);
-                cmd.exec(first + 1, last);
+                auto setup = [&](command& cmd) {
+                    cmd.parent_cmd = this;
+#ifdef CLIXX_METRICS
+                    cmd.metrics_path = metrics_path + " " + sub.name;
+#endif
+                    if (sub.callback)
+                        sub.callback(cmd);
+                };
+                if (!done) {
+                    auto cmd = command{};
+                    setup(cmd);
+                    cmd.exec(first + 1, last);
+                    return;
+                }
+                // an asynchronous action may outlive this call, the completion
+                // keeps the node (and the targets it owns) alive until it runs
+                auto cmd = std::make_shared<command>();
+                setup(*cmd);
+                auto keep = completion{
+                    [cmd, done = *done](std::exception_ptr err) { done(err); }};
+                cmd->exec(first + 1, last, &keep);
                 return;
             }
         }
     }
 
+    // arguments that follow the '--' terminator
+    auto tail_first = last;
+    auto tail_last = last;
+
     while (first != last) {
+        if (*first == "--") {
+            // terminator: the rest of the args are not parsed
+            tail_first = first + 1;
+            break;
+        }
+
         // parse the rest of the args
         auto& sv = *first++;
 
@@ -515,6 +1031,7 @@ inline void command::exec(std::string_view const* first, std::string_view const*
         cli::flag* f = nullptr;
         auto used_as = std::string{};       // for error reporting
         auto foldings = std::string_view{}; // -abcd -> bcd part
+        auto attached = false;              // -Dvalue
 
         if (sv.size() > 2 && sv[0] == '-' && sv[1] == '-') {
             // long name flag
@@ -530,6 +1047,12 @@ inline void command::exec(std::string_view const* first, std::string_view const*
             if (!f)
                 throw error{std::string{"unsupported flag "} + used_as};
             foldings = sv.substr(2, eqpos-2); // the rest of them foldings, if any
+            if (f->t.is_map() && sv.size() > 2 && sv[2] != '=') {
+                // definition attached to a single-letter flag: -Dkey=value,
+                // other flags still need '-o=value' or '-o value'
+                attached = true;
+                foldings = {};
+            }
         }
 
         if (f) {
@@ -538,7 +1061,10 @@ inline void command::exec(std::string_view const* first, std::string_view const*
                 if (!foldings.empty())
                     throw error{std::string("unsupported folding on non-boolean flag ") + used_as};
                 auto value = std::string_view{};
-                if (eqpos != std::string_view::npos) {
+                if (attached) {
+                    value = sv.substr(2);
+                }
+                else if (eqpos != std::string_view::npos) {
                     // handle: --flag=value
                     value = sv.substr(eqpos + 1);
                     if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
@@ -556,7 +1082,8 @@ inline void command::exec(std::string_view const* first, std::string_view const*
                 if (f->used() && !f->t.is_vector())
                     throw error{"duplicate flag " + used_as};
                 f->t.write(value);
-                f->used_as = used_as;
+                f->in_use = true;
+                count_flag(f);
             }
             else {
                 // boolean flag (or folding)
@@ -573,7 +1100,8 @@ inline void command::exec(std::string_view const* first, std::string_view const*
                 if (f->used())
                     throw error{"duplicate flag " + used_as};
                 f->t.write(value);
-                f->used_as = used_as;
+                f->in_use = true;
+                count_flag(f);
 
                 // process the remaining 'b', 'c', 'd' parts in the '-abcd'
                 // boolean folding if we are here, then the first letter in a
@@ -587,10 +1115,11 @@ inline void command::exec(std::string_view const* first, std::string_view const*
                         throw error{std::string{"unsupported folding on "
                                                 "non-boolean flag "} +
                                     used_as};
-                    if (!f->used_as.empty())
+                    if (f->used())
                         throw error{"duplicate flag " + used_as};
                     f->t.write(value);
-                    f->used_as = used_as;
+                    f->in_use = true;
+                    count_flag(f);
                 }
             }
         }
@@ -605,32 +1134,101 @@ inline void command::exec(std::string_view const* first, std::string_view const*
         cmd = cmd->parent_cmd;
     }
 
-    collect_arguments(arg_strings.data(), arg_strings.data() + arg_strings.size());
+    if (arguments.empty() || !arguments.back().t.is_passthrough()) {
+        // without a passthrough argument the tail is a sequence of arguments
+        arg_strings.insert(arg_strings.end(), tail_first, tail_last);
+        tail_first = tail_last;
+    }
+
+    collect_arguments(arg_strings.data(), arg_strings.data() + arg_strings.size(), tail_first,
+        tail_last);
+    finish_targets();
+
+    count_parse();
+
+    if (async_action) {
+        if (done) {
+            async_action(*done);
+            return;
+        }
+        // synchronous execution waits for the completion
+        auto p = std::promise<void>{};
+        auto f = p.get_future();
+        async_action([&p](std::exception_ptr err) {
+            if (err)
+                p.set_exception(err);
+            else
+                p.set_value();
+        });
+        f.get();
+        return;
+    }
 
     if (action)
         action();
+    if (done)
+        (*done)(nullptr);
 }
 
-inline void command::collect_arguments(std::string_view const* first, std::string_view const* last)
+inline void command::count_command()
+{
+#ifdef CLIXX_METRICS
+    metrics::instance().hit(metrics_path);
+#endif
+}
+
+inline void command::count_flag([[maybe_unused]] cli::flag const* f)
+{
+#ifdef CLIXX_METRICS
+    metrics::instance().hit(metrics_path, f->printable_name());
+#endif
+}
+
+inline void command::count_parse()
+{
+#ifdef CLIXX_METRICS
+    auto root = static_cast<command const*>(this);
+    while (root->parent_cmd)
+        root = root->parent_cmd;
+    auto dt = std::chrono::steady_clock::now() - root->parse_start;
+    metrics::instance().observe(metrics_path, dt);
+#endif
+}
+
+inline void command::collect_arguments(std::string_view const* first,
+    std::string_view const* last, std::string_view const* tail_first,
+    std::string_view const* tail_last)
 {
     if (arguments.empty()) {
         if (first != last)
             throw error{std::string{"unexpected argument: "} + std::string{*first}};
+        check_paths();
         return;
     }
     auto b = arguments.begin();
     auto e = arguments.end();
 
+    if ((e - 1)->t.is_passthrough()) {
+        --e;
+        if (e->t.required && tail_first == tail_last)
+            throw error{std::string{"missing argument: "} + std::string{e->name}};
+        auto root = static_cast<command const*>(this);
+        while (root->parent_cmd)
+            root = root->parent_cmd;
+        auto raw = root->raw_argv ? root->raw_argv + (tail_first - root->raw_first) : nullptr;
+        e->t.write_tail(tail_first, tail_last, raw);
+    }
+
     while (b != e && b->t.required && !b->t.is_vector()) {
         if (first == last)
-            throw error{std::string{"missing argument: "} + b->name};
+            throw error{std::string{"missing argument: "} + std::string{b->name}};
         b->t.write(*first);
         ++b;
         ++first;
     }
     while (b != e && (e - 1)->t.required && !(e - 1)->t.is_vector()) {
         if (first == last)
-            throw error{std::string{"missing argument: "} + b->name};
+            throw error{std::string{"missing argument: "} + std::string{b->name}};
         --e;
         --last;
         b->t.write(*last);
@@ -646,7 +1244,7 @@ inline void command::collect_arguments(std::string_view const* first, std::strin
     }
     if (b != e && b->t.is_vector()) {
         if (b->t.required && first == last)
-            throw error{std::string{"missing argument: "} + b->name};
+            throw error{std::string{"missing argument: "} + std::string{b->name}};
         while (first != last) {
             b->t.write(*first);
             ++first;
@@ -657,6 +1255,28 @@ inline void command::collect_arguments(std::string_view const* first, std::strin
         throw error{"invalid argument declaration"};
     if (first != last)
         throw error{std::string{"unexpected argument: "} + std::string{*first}};
+
+    check_paths();
+}
+
+inline void command::finish_targets()
+{
+    for (auto& arg : arguments)
+        arg.t.finish();
+    for (auto cmd = this; cmd; cmd = cmd->parent_cmd)
+        cmd->flags.finish();
+}
+
+inline void command::check_paths() const
+{
+    // validate path targets of this command and its parents as a batch
+    auto targets = std::vector<path_list const*>{};
+    for (auto& arg : arguments)
+        if (auto p = arg.t.paths())
+            targets.push_back(p);
+    for (auto cmd = this; cmd; cmd = cmd->parent_cmd)
+        cmd->flags.collect_paths(targets);
+    internal::check_paths(targets);
 }
 
 inline auto command::trace_usage(  //
@@ -682,13 +1302,424 @@ inline auto command::trace_usage(  //
     return usage(exe_prefix, cmd_prefix, cmd_desc, help_cmd);
 }
 
-inline void app::execute(std::string_view const* first, std::string_view const* last)
+inline void command::walk(visitor const& v, std::string const& path, std::string const& desc)
+{
+    v(*this, path, desc);
+    for (auto& sub : subcommands) {
+        auto cmd = command{};
+        cmd.parent_cmd = this;
+        if (sub.callback)
+            sub.callback(cmd);
+        cmd.walk(v, path.empty() ? sub.name : path + " " + sub.name, sub.desc);
+    }
+}
+
+inline auto app::help_message(command const& cmd, std::string const& path,
+    std::string const& cmd_desc) const -> std::string
+{
+    auto msg = desc;
+    if (!msg.empty())
+        msg += '\n';
+    if (path.empty())
+        msg += cmd.usage(name, "", "", help_command());
+    else
+        msg += cmd.usage(name, " " + path, cmd_desc, help_command());
+    return msg;
+}
+
+inline auto app::help_pages(unsigned nthreads)
+    -> std::vector<std::pair<std::string, std::string>>
+{
+    auto ret = std::vector<std::pair<std::string, std::string>>{};
+    for (auto& page : document(nthreads))
+        ret.push_back({std::move(page.path), std::move(page.usage)});
+    std::sort(ret.begin(), ret.end());
+    return ret;
+}
+
+inline auto app::document(unsigned nthreads) -> std::vector<doc_page>
 {
+    // subcommand callbacks are not required to be thread-safe, the tree is
+    // built sequentially; rendering only reads the nodes
+    auto tree = build_tree();
+    tree.nodes.front().desc = desc;
+    auto pages = std::vector<doc_page>(tree.nodes.size());
+    {
+        auto pool = thread_pool{nthreads};
+        for (size_t i = 0; i < tree.nodes.size(); ++i)
+            pool.post([&, i]() {
+                auto& n = tree.nodes[i];
+                pages[i].path = n.path;
+                pages[i].usage = help_message(*n.cmd, n.path, n.desc);
+                pages[i].schema = n.cmd->schema(n.path, n.desc);
+            });
+        pool.wait();
+    }
+    return pages;
+}
+
+inline auto app::export_schema(unsigned nthreads) -> std::string
+{
+    auto ret = std::string{"["};
+    auto pages = document(nthreads);
+    for (auto& page : pages) {
+        if (&page != &pages.front())
+            ret += ",";
+        ret += "\n";
+        ret += page.schema;
+    }
+    ret += "\n]\n";
+    return ret;
+}
+
+inline auto app::find_static_help(
+    std::string_view const* first, std::string_view const* last) const -> static_help const*
+{
+    if (!help_table)
+        return nullptr;
+    auto b = help_table;
+    auto e = help_table + help_table_size;
+    auto find = [&](std::string_view path) -> static_help const* {
+        auto it = std::lower_bound(
+            b, e, path, [](static_help const& h, std::string_view p) { return h.path < p; });
+        return it != e && it->path == path ? it : nullptr;
+    };
+
+    // the longest subcommand path that matches the arguments
+    auto ret = find({});
+    auto path = std::string{};
+    for (; first != last; ++first) {
+        auto candidate = path.empty() ? std::string{*first} : path + " " + std::string{*first};
+        auto page = find(candidate);
+        if (!page)
+            break;
+        path = candidate;
+        ret = page;
+    }
+    return ret;
+}
+
+inline auto command::build_tree() -> command_tree
+{
+    auto tree = command_tree{};
+    build_tree(tree, {}, {}, std::string::npos, {});
+    return tree;
+}
+
+inline void command::build_tree(command_tree& tree, std::string const& path,
+    std::string const& desc, size_t parent, std::chrono::nanoseconds build_time)
+{
+    auto index = tree.nodes.size();
+    tree.nodes.push_back({path, desc, this, parent, build_time});
+    for (auto& sub : subcommands) {
+        auto& cmd = *tree.owned.emplace_back(std::make_unique<command>());
+        cmd.parent_cmd = this;
+        auto t0 = std::chrono::steady_clock::now();
+        if (sub.callback)
+            sub.callback(cmd);
+        auto dt = std::chrono::steady_clock::now() - t0;
+        cmd.build_tree(tree, path.empty() ? sub.name : path + " " + sub.name, sub.desc, index,
+            std::chrono::duration_cast<std::chrono::nanoseconds>(dt));
+    }
+}
+
+inline auto command::measure() const -> footprint
+{
+    auto ret = footprint{};
+    std::function<void(flag_list const&)> add_flags = [&](flag_list const& fl) {
+        ret.target_bytes += fl.items.capacity() * sizeof(flag_list::item);
+        for (auto& it : fl.items)
+            if (auto v = std::get_if<flag_list>(&it))
+                add_flags(*v);
+            else if (auto f = std::get_if<cli::flag>(&it)) {
+                ret.name_bytes += f->name.size() + f->letters.size() + f->sample.size();
+                ret.desc_bytes += f->desc.size();
+            }
+    };
+    add_flags(flags);
+
+    ret.target_bytes += arguments.capacity() * sizeof(argument);
+    for (auto& arg : arguments) {
+        ret.name_bytes += arg.name.size();
+        ret.desc_bytes += arg.desc.size();
+    }
+
+    // heap blocks of short strings and of callback captures are not visible,
+    // strings are counted by their capacity beyond the inline buffer
+    auto heap = [](std::string const& s) {
+        return s.capacity() > std::string{}.capacity() ? s.capacity() + 1 : size_t{0};
+    };
+    ret.children_bytes += subcommands.capacity() * sizeof(subcmd);
+    for (auto& sub : subcommands) {
+        ret.name_bytes += heap(sub.name);
+        ret.desc_bytes += heap(sub.desc);
+    }
+    ret.target_bytes += index.hashes.capacity() * sizeof(uint32_t) +
+                        index.flags.capacity() * sizeof(cli::flag*) +
+                        (index.letters ? sizeof(flag_index::letter_table) : 0);
+    return ret;
+}
+
+inline auto command::schema(std::string const& path, std::string const& desc) const
+    -> std::string
+{
+    using internal::json_string;
+    auto ret = std::string{"{\"path\":"} + json_string(path) + ",\"desc\":" + json_string(desc);
+
+    // allowed values of choice targets
+    auto choices = [](target const& t) {
+        auto c = t.choices();
+        if (!c)
+            return std::string{};
+        auto ret = std::string{",\"choices\":["};
+        for (size_t i = 0; i < c->size(); ++i)
+            ret += (i ? "," : "") + json_string(c->name(i));
+        return ret + "]";
+    };
+
+    ret += ",\"subcommands\":[";
+    for (auto& sub : subcommands) {
+        if (&sub != &subcommands.front())
+            ret += ",";
+        ret += json_string(sub.name);
+    }
+
+    std::function<void(flag_list const&)> add_flags = [&](flag_list const& fl) {
+        ret += "[";
+        for (auto& it : fl.items) {
+            if (&it != &fl.items.front())
+                ret += ",";
+            if (auto v = std::get_if<flag_list>(&it)) {
+                ret += std::string{"{\"group\":{\"required\":"} +
+                       (v->required ? "true" : "false") +
+                       ",\"exclusive\":" + (v->exclusive ? "true" : "false") + ",\"flags\":";
+                add_flags(*v);
+                ret += "}}";
+            }
+            else if (auto f = std::get_if<cli::flag>(&it)) {
+                ret += "{\"name\":" + json_string(f->name) +
+                       ",\"letters\":" + json_string(f->letters) +
+                       ",\"sample\":" + json_string(f->sample) +
+                       ",\"desc\":" + json_string(f->desc) +
+                       ",\"kind\":" + json_string(f->t.kind()) + choices(f->t) +
+                       ",\"required\":" + (f->t.required ? "true" : "false") +
+                       ",\"multiple\":" + (f->t.is_vector() ? "true" : "false") + "}";
+            }
+        }
+        ret += "]";
+    };
+    ret += "],\"flags\":";
+    add_flags(flags);
+
+    ret += ",\"arguments\":[";
+    for (auto& arg : arguments) {
+        if (&arg != &arguments.front())
+            ret += ",";
+        ret += "{\"name\":" + json_string(arg.name) + ",\"desc\":" + json_string(arg.desc) +
+               ",\"kind\":" + json_string(arg.t.kind()) + choices(arg.t) +
+               ",\"required\":" + (arg.t.required ? "true" : "false") +
+               ",\"multiple\":" + (arg.t.is_vector() ? "true" : "false") + "}";
+    }
+    ret += "]}";
+    return ret;
+}
+
+inline auto app::introspect() -> std::vector<footprint>
+{
+    auto tree = build_tree();
+    auto ret = std::vector<footprint>{};
+    ret.reserve(tree.nodes.size());
+    for (auto& n : tree.nodes) {
+        auto& fp = ret.emplace_back(n.cmd->measure());
+        fp.path = n.path.empty() ? name : name + " " + n.path;
+        fp.build_time = n.build_time;
+    }
+
+    // pre-order: children follow their parents, accumulate bottom-up
+    for (auto& fp : ret) {
+        fp.subtree_bytes = fp.bytes();
+        fp.subtree_time = fp.build_time;
+    }
+    for (auto i = tree.nodes.size(); i-- > 1;) {
+        auto& parent = ret[tree.nodes[i].parent];
+        parent.subtree_bytes += ret[i].subtree_bytes;
+        parent.subtree_time += ret[i].subtree_time;
+    }
+    return ret;
+}
+
+inline auto app::report(std::vector<footprint> nodes, size_t limit) -> std::string
+{
+    std::stable_sort(nodes.begin(), nodes.end(), [](footprint const& a, footprint const& b) {
+        if (a.subtree_time != b.subtree_time)
+            return a.subtree_time > b.subtree_time;
+        return a.subtree_bytes > b.subtree_bytes;
+    });
+    if (limit && nodes.size() > limit)
+        nodes.resize(limit);
+
+    auto us = [](std::chrono::nanoseconds t) {
+        return std::to_string(t.count() / 1000) + "." + std::to_string(t.count() % 1000 / 100);
+    };
+    auto w = writer{};
+    w.cols({"build us", "subtree us", "names", "descs", "targets", "children", "subtree",
+        "command"});
+    for (auto& fp : nodes)
+        w.cols({us(fp.build_time), us(fp.subtree_time), std::to_string(fp.name_bytes),
+            std::to_string(fp.desc_bytes), std::to_string(fp.target_bytes),
+            std::to_string(fp.children_bytes), std::to_string(fp.subtree_bytes), fp.path});
+    w.done_cols("", "  ");
+    return w.buf;
+}
+
+inline auto app::build_search_index() -> cli::search_index
+{
+    auto idx = cli::search_index{};
+    walk([&](command const& cmd, std::string const& path, std::string const& cmd_desc) {
+        auto id = idx.add_doc(path, extract_short(cmd_desc));
+        auto slash = path.rfind(' ');
+        idx.add_text(id, slash == std::string::npos ? path : path.substr(slash + 1), 8);
+        idx.add_text(id, cmd_desc, 2);
+        std::function<void(flag_list const&)> add_flags = [&](flag_list const& fl) {
+            for (auto& it : fl.items)
+                if (auto v = std::get_if<flag_list>(&it))
+                    add_flags(*v);
+                else if (auto f = std::get_if<cli::flag>(&it)) {
+                    idx.add_text(id, f->name, 2);
+                    idx.add_text(id, f->desc, 1);
+                }
+        };
+        add_flags(cmd.flags);
+        for (auto& arg : cmd.arguments) {
+            idx.add_text(id, arg.name, 1);
+            idx.add_text(id, arg.desc, 1);
+        }
+    });
+    return idx;
+}
+
+inline auto app::index_location(std::string& id) const -> std::filesystem::path
+{
+    auto ec = std::error_code{};
+    auto fn = search_index_path;
+
+    // argv[0] is a bare name when the tool is started from PATH
+    auto exe = internal::executable_file(executable_path);
+
+    // tools of a multicall binary share the executable, each keeps its own
+    // index: 'multi.ls.search-index' for both 'ls' and 'multi ls'
+    auto tool = std::string_view{name};
+    if (auto n = tool.rfind(' '); n != std::string_view::npos)
+        tool.remove_prefix(n + 1);
+    if (tool == exe.filename().string() || tool == exe.stem().string())
+        tool = {};
+
+    if (fn.empty()) {
+        if (!std::filesystem::is_regular_file(exe, ec))
+            return {};
+        fn = exe;
+        if (!tool.empty())
+            fn += "." + std::string{tool};
+        fn += ".search-index";
+    }
+    id = build_id;
+    if (id.empty()) {
+        auto size = std::filesystem::file_size(exe, ec);
+        if (ec)
+            return {};
+        auto mtime = std::filesystem::last_write_time(exe, ec);
+        if (ec)
+            return {};
+        id = std::to_string(size) + ":" + std::to_string(mtime.time_since_epoch().count());
+    }
+    if (!tool.empty())
+        id = std::string{tool} + ":" + id;
+    return fn;
+}
+
+inline auto app::load_search_index() -> cli::search_index
+{
+    auto id = std::string{};
+    auto fn = index_location(id);
+    auto idx = cli::search_index{};
+    if (!fn.empty() && idx.load(fn, id))
+        return idx;
+    idx = build_search_index();
+    if (!fn.empty())
+        idx.save(fn, id); // the index is rebuilt next time if this fails
+    return idx;
+}
+
+inline auto app::search(std::string_view terms) -> std::string
+{
+    auto idx = load_search_index();
+    auto found = idx.query(terms);
+    auto w = writer{};
+    if (found.empty()) {
+        w.line(std::string{"\nno commands found for '"} + std::string{terms} + "'");
+        return w.buf;
+    }
+    w.line("\ncommands:");
+    for (auto& m : found) {
+        auto& d = idx.docs[m.doc];
+        w.cols({d.path.empty() ? std::string_view{name} : std::string_view{d.path}, d.desc});
+    }
+    w.done_cols("    ", "  ");
+    w.line("");
+    return w.buf;
+}
+
+inline void app::execute_async(
+    std::vector<std::string> cmdline, executor const& ex, completion done)
+{
+    // the command line is owned until completion, as lazy and passthrough
+    // targets may refer to it from within asynchronous actions
+    struct state {
+        std::vector<std::string> strings;
+        std::vector<std::string_view> views;
+        std::atomic<bool> completed = false;
+        completion done;
+    };
+    auto st = std::make_shared<state>();
+    st->strings = std::move(cmdline);
+    st->views.assign(st->strings.begin(), st->strings.end());
+    st->done = std::move(done);
+
+    ex([this, st]() {
+        auto finish = completion{[st](std::exception_ptr err) {
+            if (!st->completed.exchange(true))
+                st->done(err);
+        }};
+        try {
+            execute_raw(st->views.data(), st->views.data() + st->views.size(), nullptr, &finish);
+        }
+        catch (...) {
+            finish(std::current_exception());
+        }
+    });
+}
+
+inline void app::execute_raw(std::string_view const* first, std::string_view const* last,
+    char* const* raw, completion const* done)
+{
+    raw_argv = raw;
+    raw_first = first;
+#ifdef CLIXX_METRICS
+    parse_start = std::chrono::steady_clock::now();
+#endif
+
+    // allows executing the same app more than once
+    flags.reset();
+    index.clear();
+
     if (first != last) {
         executable_path = *first++;
         if (name.empty())
             name = executable_path.filename().replace_extension("").string();
     }
+#ifdef CLIXX_METRICS
+    metrics_path = name;
+#endif
 
     // check for help:
     auto show_help = false;
@@ -703,18 +1734,359 @@ inline void app::execute(std::string_view const* first, std::string_view const*
         }
     }
 
+    if (show_help && first != last && !search_flag.empty() && *first == search_flag) {
+        auto terms = std::string{};
+        for (++first; first != last; ++first) {
+            if (!terms.empty())
+                terms += ' ';
+            terms += *first;
+        }
+        throw help{search(terms)};
+    }
+
     if (show_help) {
+        if (auto page = find_static_help(first, last))
+            throw help{std::string{page->text}};
         auto msg = desc;
         if (!msg.empty())
             msg += '\n';
-        auto h = help_cmd;
-        if (h.empty())
-            h = help_flag;
-        msg += trace_usage(name, "", "", h, first, last);
+        msg += trace_usage(name, "", "", help_command(), first, last);
         throw help{msg};
     }
 
-    exec(first, last);
+    exec(first, last, done);
+}
+
+inline auto batch::execute(std::string_view const* first, std::string_view const* last)
+    -> std::vector<result>
+{
+    if (first == last)
+        throw error{"missing executable name"};
+    auto exe = *first++;
+
+    // empty invocations (leading, trailing, or repeated separators) are
+    // skipped; after '--' the rest of the command line belongs to the
+    // current invocation
+    auto results = std::vector<result>{};
+    auto args = std::vector<std::string>{};
+    auto terminated = false;
+    for (;; ++first) {
+        if (first == last || (!terminated && *first == separator)) {
+            if (!args.empty())
+                results.emplace_back().args = std::move(args);
+            args.clear();
+            if (first == last)
+                break;
+        }
+        else {
+            terminated = terminated || *first == "--";
+            args.emplace_back(*first);
+        }
+    }
+
+    if (!parallel || results.size() < 2) {
+        for (auto& r : results)
+            run(exe, r);
+        return results;
+    }
+
+    auto n = nthreads ? nthreads : std::thread::hardware_concurrency();
+    auto pool = thread_pool{unsigned(std::min<size_t>(std::max(1u, n), results.size()))};
+    for (auto& r : results)
+        pool.post([this, exe, &r]() { run(exe, r); });
+    pool.wait();
+    return results;
+}
+
+inline auto batch::execute(int argc, char* argv[]) -> std::vector<result>
+{
+    auto args = std::vector<std::string_view>{};
+    args.reserve(argc);
+    for (auto i = 0; i < argc; ++i)
+        args.push_back(argv[i]);
+    return execute(args.data(), args.data() + args.size());
+}
+
+inline void batch::run(std::string_view exe, result& r) const
+{
+    auto out = std::ostringstream{};
+    try {
+        auto a = app{name, desc};
+        if (setup)
+            setup(a, out);
+        auto views = std::vector<std::string_view>{exe};
+        views.insert(views.end(), r.args.begin(), r.args.end());
+        a.execute(views.data(), views.data() + views.size());
+    }
+    catch (help const& msg) {
+        r.message = msg.what();
+    }
+    catch (std::exception const& e) {
+        r.status = 1;
+        r.message = e.what();
+    }
+    r.output = out.str();
+}
+
+inline auto batch::status(std::vector<result> const& results) -> int
+{
+    for (auto& r : results)
+        if (r.status)
+            return r.status;
+    return 0;
+}
+
+inline auto batch::combined(std::vector<result> const& results) -> std::string
+{
+    auto ret = std::string{};
+    for (auto& r : results) {
+        ret += r.output;
+        if (!r.message.empty()) {
+            ret += r.status ? "error: " + r.message : r.message;
+            ret += '\n';
+        }
+    }
+    return ret;
+}
+
+inline auto multicall::registry() -> std::vector<tool>&
+{
+    // function-local static avoids static initialization order issues
+    // between translation units that register tools
+    static auto tools = std::vector<tool>{};
+    return tools;
+}
+
+inline void multicall::add(std::string const& name, std::string const& desc, factory setup)
+{
+    if (find(name))
+        throw std::logic_error{"multicall: duplicate tool name: " + name};
+    registry().push_back(tool{name, desc, setup});
+}
+
+inline auto multicall::find(std::string_view name) -> tool const*
+{
+    for (auto& t : registry())
+        if (t.name == name)
+            return &t;
+    return nullptr;
+}
+
+inline auto multicall::list(std::string const& exe_prefix) -> std::string
+{
+    auto w = writer{};
+    w.line("\nsyntax:");
+    w.line(std::string("    ") + exe_prefix + " <tool> ...");
+    w.line("\ntools:");
+    for (auto& t : registry())
+        w.cols({t.name, extract_short(t.desc)});
+    w.done_cols("    ", "  ");
+    w.line("");
+    return w.buf;
+}
+
+inline void multicall::execute(std::string_view const* first, std::string_view const* last)
+{
+    dispatch(first, last, nullptr);
+}
+
+inline void multicall::dispatch(
+    std::string_view const* first, std::string_view const* last, char* const* raw)
+{
+    if (first == last)
+        throw error{"missing executable name"};
+
+    // the tool is selected by the executable name (a symlink or a hardlink
+    // to the shared binary), only the selected app is constructed; names may
+    // contain dots (mkfs.ext4), only the .exe suffix is dropped
+    auto fn = std::filesystem::path{*first}.filename();
+    if (fn.extension() == ".exe" || fn.extension() == ".EXE")
+        fn.replace_extension();
+    auto exe = fn.string();
+    if (auto t = find(exe)) {
+        auto a = app{t->name, t->desc};
+        if (t->setup)
+            t->setup(a);
+        a.execute_raw(first, last, raw);
+        return;
+    }
+
+    // fallback: 'multi <tool> ...'
+    if (first + 1 == last)
+        throw help{list(exe)};
+    auto t = find(first[1]);
+    if (!t) {
+        if (first[1] == "--help" || first[1] == "help")
+            throw help{list(exe)};
+        throw error{std::string{"unknown tool: "} + std::string{first[1]}};
+    }
+    auto a = app{exe + " " + t->name, t->desc};
+    if (t->setup)
+        t->setup(a);
+    a.execute_raw(first + 1, last, raw ? raw + 1 : nullptr);
+}
+
+inline void multicall::execute(int argc, char* argv[])
+{
+    auto args = std::vector<std::string_view>{};
+    args.reserve(argc);
+    for (auto i = 0; i < argc; ++i)
+        args.push_back(argv[i]);
+    dispatch(args.data(), args.data() + args.size(), argv);
+}
+
+inline void multicall::execute(int argc, wchar_t* argv[])
+{
+    auto strings = std::vector<std::string>{};
+    auto args = std::vector<std::string_view>{};
+    auto raw = std::vector<char*>{};
+    args.reserve(argc);
+    strings.reserve(argc);
+    raw.reserve(argc + 1);
+    for (auto i = 0; i < argc; ++i) {
+        auto conv = std::filesystem::path{argv[i]};
+        strings.push_back(conv.string());
+        args.push_back(strings.back());
+        raw.push_back(strings.back().data());
+    }
+    raw.push_back(nullptr);
+    dispatch(args.data(), args.data() + args.size(), raw.data());
+}
+
+inline cursor::cursor(app& root)
+    : root{root}
+{
+    root.index.clear();
+    auto& st = states.emplace_back();
+    st.node = &root;
+}
+
+inline auto cursor::node(command* parent, std::string const& path, command::subcmd const& sub)
+    -> command*
+{
+    for (auto& [p, n] : nodes)
+        if (p == path)
+            return n.get();
+    auto n = std::make_unique<command>();
+    n->parent_cmd = parent;
+    if (sub.callback)
+        sub.callback(*n);
+    nodes.push_back({path, std::move(n)});
+    return nodes.back().second.get();
+}
+
+inline auto cursor::step(state const& st, std::string_view tok) -> state
+{
+    auto ret = st;
+    auto use = [&](cli::flag const* f) {
+        ret.used = std::make_shared<used_flags const>(used_flags{f, ret.used});
+    };
+
+    if (st.pending) {
+        ret.pending = nullptr;
+        return ret;
+    }
+    ret.at_command = false;
+    if (st.terminated) {
+        ++ret.positional;
+        return ret;
+    }
+    if (tok == "--") {
+        ret.terminated = true;
+        return ret;
+    }
+    if (st.at_command)
+        for (auto& sub : st.node->subcommands)
+            if (sub.name == tok) {
+                ret.path = st.path.empty() ? sub.name : st.path + " " + sub.name;
+                ret.node = node(st.node, ret.path, sub);
+                ret.at_command = true;
+                return ret;
+            }
+
+    auto eqpos = tok.find('=');
+    if (tok.size() > 2 && tok[0] == '-' && tok[1] == '-') {
+        if (auto f = st.node->find_flag(tok.substr(2, eqpos - 2), false)) {
+            use(f);
+            if (!f->t.is_bool() && eqpos == std::string_view::npos)
+                ret.pending = f;
+        }
+    }
+    else if (tok.size() > 1 && tok[0] == '-') {
+        if (auto f = st.node->find_flag(tok.substr(1, 1), true)) {
+            use(f);
+            if (!f->t.is_bool()) {
+                if (tok.size() == 2)
+                    ret.pending = f;
+            }
+            else
+                for (auto c : tok.substr(2, eqpos - 2))
+                    if (auto ff = st.node->find_flag({&c, 1}, true))
+                        use(ff);
+        }
+    }
+    else
+        ++ret.positional;
+    return ret;
+}
+
+inline void cursor::update(std::string_view const* first, std::string_view const* last)
+{
+    auto n = size_t(last - first);
+    auto common = size_t{0};
+    while (common < n && common < tokens.size() && tokens[common] == first[common])
+        ++common;
+    tokens.resize(common);
+    states.resize(common + 1);
+    for (auto i = common; i < n; ++i) {
+        tokens.emplace_back(first[i]);
+        states.push_back(step(states.back(), first[i]));
+    }
+}
+
+inline auto cursor::complete(std::string_view partial) const -> std::vector<std::string>
+{
+    auto ret = std::vector<std::string>{};
+    auto& st = current();
+    auto starts_with = [&](std::string const& s) {
+        return s.size() >= partial.size() && s.compare(0, partial.size(), partial) == 0;
+    };
+
+    if (st.pending) {
+        // values of a choice flag
+        if (auto c = st.pending->t.choices())
+            for (size_t i = 0; i < c->size(); ++i)
+                if (starts_with(std::string{c->name(i)}))
+                    ret.emplace_back(c->name(i));
+        return ret;
+    }
+    if (st.terminated)
+        return ret;
+
+    if (!partial.empty() && partial[0] == '-') {
+        std::function<void(flag_list const&)> add = [&](flag_list const& fl) {
+            for (auto& it : fl.items)
+                if (auto v = std::get_if<flag_list>(&it))
+                    add(*v);
+                else if (auto f = std::get_if<cli::flag>(&it)) {
+                    if (st.is_used(f) && !f->t.is_vector())
+                        continue;
+                    if (!f->name.empty() && starts_with("--" + std::string{f->name}))
+                        ret.push_back("--" + std::string{f->name});
+                    else if (f->name.empty() && !f->letters.empty() &&
+                             starts_with(std::string{"-"} + f->letters[0]))
+                        ret.push_back(std::string{"-"} + f->letters[0]);
+                }
+        };
+        for (command const* cmd = st.node; cmd; cmd = cmd->parent_cmd)
+            add(cmd->flags);
+    }
+    else if (st.at_command) {
+        for (auto& sub : st.node->subcommands)
+            if (starts_with(sub.name))
+                ret.push_back(sub.name);
+    }
+    return ret;
 }
 
 } // namespace cli
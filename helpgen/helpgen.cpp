@@ -0,0 +1,162 @@
+// helpgen renders help messages, man pages, and markdown docs for an app
+// schema at build time, see clixx_add_help_tables in CMakeLists.txt
+//
+// The schema source that is linked with this generator must define:
+//
+//     void clixx_schema(cli::app& a);
+
+#include <cli++.hpp>
+#include <cstdio>
+#include <fstream>
+
+extern void clixx_schema(cli::app& a);
+
+namespace {
+
+auto c_literal(std::string_view s) -> std::string
+{
+    // long literals are split into chunks to stay within compiler limits
+    constexpr auto chunk = size_t{2000};
+    auto ret = std::string{"\""};
+    auto n = size_t{0};
+    for (auto c : s) {
+        if (n >= chunk) {
+            ret += "\"\n        \"";
+            n = 0;
+        }
+        switch (c) {
+        case '\n': ret += "\\n"; break;
+        case '\t': ret += "\\t"; break;
+        case '"': ret += "\\\""; break;
+        case '\\': ret += "\\\\"; break;
+        default:
+            if ((unsigned char)(c) < 32) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\%03o", unsigned((unsigned char)(c)));
+                ret += buf;
+            }
+            else
+                ret += c;
+        }
+        ++n;
+    }
+    ret += '"';
+    return ret;
+}
+
+auto man_escape(std::string_view s) -> std::string
+{
+    auto ret = std::string{};
+    auto bol = true;
+    for (auto c : s) {
+        if (bol && (c == '.' || c == '\''))
+            ret += "\\&";
+        if (c == '\\')
+            ret += "\\e";
+        else if (c == '-')
+            ret += "\\-";
+        else
+            ret += c;
+        bol = c == '\n';
+    }
+    return ret;
+}
+
+using pages = std::vector<std::pair<std::string, std::string>>;
+
+void write_header(std::ostream& os, pages const& pp, std::string const& ns)
+{
+    os << "// generated by clixx helpgen, do not edit\n";
+    os << "#pragma once\n\n";
+    os << "#include <cli++.hpp>\n\n";
+    os << "namespace " << ns << " {\n\n";
+    os << "inline constexpr cli::static_help help_table[] = {\n";
+    for (auto& [path, text] : pp)
+        os << "    {" << c_literal(path) << ",\n        " << c_literal(text) << "},\n";
+    os << "};\n\n";
+    os << "} // namespace " << ns << "\n";
+}
+
+void write_man(std::ostream& os, pages const& pp, cli::app const& a)
+{
+    os << ".TH " << man_escape(a.name) << " 1\n";
+    os << ".SH NAME\n" << man_escape(a.name);
+    if (!a.desc.empty())
+        os << " \\- " << man_escape(std::string{cli::extract_short(a.desc)});
+    os << "\n";
+    for (auto& [path, text] : pp) {
+        os << ".SH " << (path.empty() ? "SYNOPSIS" : "COMMAND \"" + man_escape(path) + "\"")
+           << "\n";
+        os << ".nf\n" << man_escape(text) << "\n.fi\n";
+    }
+}
+
+void write_markdown(std::ostream& os, pages const& pp, cli::app const& a)
+{
+    os << "# " << a.name << "\n";
+    for (auto& [path, text] : pp) {
+        if (!path.empty())
+            os << "\n## " << a.name << " " << path << "\n";
+        os << "\n```\n" << text << "```\n";
+    }
+}
+
+template <typename F> auto write_file(std::string const& fn, F&& fn_write) -> bool
+{
+    if (fn.empty())
+        return true;
+    auto f = std::ofstream{fn, std::ios::binary};
+    fn_write(f);
+    if (!f) {
+        std::fprintf(stderr, "helpgen: failed to write %s\n", fn.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+auto main(int argc, char* argv[]) -> int
+{
+    auto header = std::string{};
+    auto ns = std::string{"help"};
+    auto man = std::string{};
+    auto markdown = std::string{};
+    auto exe_name = std::string{};
+
+    auto cl = cli::app{"helpgen", "generates help tables, man pages, and markdown docs"};
+    cl.flag({header, false}, "header", "", "output C++ header with a static help table", "file");
+    cl.flag({ns, false}, "namespace", "", "namespace for the help table", "name");
+    cl.flag({man, false}, "man", "", "output man page", "file");
+    cl.flag({markdown, false}, "markdown", "", "output markdown document", "file");
+    cl.flag({exe_name, false}, "name", "", "executable name", "name");
+
+    try {
+        cl.execute(argc, argv);
+    }
+    catch (const cli::help& msg) {
+        std::printf("%s\n", msg.what());
+        return 0;
+    }
+    catch (const cli::error& msg) {
+        std::fprintf(stderr, "helpgen: %s\n", msg.what());
+        return 1;
+    }
+
+    auto a = cli::app{""};
+    clixx_schema(a);
+    if (!exe_name.empty())
+        a.name = exe_name;
+    if (a.name.empty()) {
+        // the pages would differ from the runtime help, which uses the name
+        // of the executable
+        std::fprintf(stderr, "helpgen: no executable name, use --name\n");
+        return 1;
+    }
+
+    auto pp = a.help_pages();
+    auto ok = write_file(header, [&](std::ostream& os) { write_header(os, pp, ns); }) &&
+              write_file(man, [&](std::ostream& os) { write_man(os, pp, a); }) &&
+              write_file(markdown, [&](std::ostream& os) { write_markdown(os, pp, a); });
+    return ok ? 0 : 1;
+}
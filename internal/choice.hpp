@@ -0,0 +1,208 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "error.hpp"
+
+namespace cli {
+
+namespace internal {
+
+constexpr auto choice_hash(std::string_view s) -> uint32_t
+{
+    auto h = uint32_t{2166136261u};
+    for (auto c : s)
+        h = (h ^ uint8_t(c)) * 16777619u;
+    return h;
+}
+
+// derives a seeded hash from choice_hash, the names are hashed only once
+// while searching for a seed
+constexpr auto choice_mix(uint32_t h, uint32_t seed) -> uint32_t
+{
+    h ^= seed * 0x9e3779b9u;
+    h = (h ^ (h >> 16)) * 0x85ebca6bu;
+    h = (h ^ (h >> 13)) * 0xc2b2ae35u;
+    return h ^ (h >> 16);
+}
+
+constexpr auto next_pow2(size_t n) -> size_t
+{
+    auto ret = size_t{1};
+    while (ret < n)
+        ret *= 2;
+    return ret;
+}
+
+} // namespace internal
+
+// choices is a compile-time table of the values of an enum-valued flag or
+// argument. The names are placed into a perfect hash table at compile time
+// (hash and displace: names are grouped into buckets, each bucket gets a
+// seed that maps its names into free slots). A token is resolved with a
+// single hash of the name and a single comparison:
+//
+//     static constexpr auto formats = cli::make_choices<format>(
+//         {{"json", format::json}, {"csv", format::csv}, {"table", format::table}});
+//     static auto fmt = cli::choice<format>{formats, format::table};
+template <typename E, size_t N> class choices {
+public:
+    static_assert(N > 0 && N < 255, "choices: unsupported number of values");
+
+    static constexpr size_t table_size = internal::next_pow2(N) * 2;
+    static constexpr size_t bucket_count = (internal::next_pow2(N) + 1) / 2;
+
+    std::array<std::string_view, N> names{};
+    std::array<E, N> values{};
+    std::array<uint16_t, bucket_count> seeds{};
+    std::array<uint8_t, table_size> slots{}; // index + 1, zero when empty
+
+    constexpr choices(std::pair<char const*, E> const (&list)[N])
+    {
+        auto hashes = std::array<uint32_t, N>{};
+        auto buckets = std::array<size_t, N>{};
+        auto sizes = std::array<size_t, bucket_count>{};
+        for (size_t i = 0; i < N; ++i) {
+            names[i] = list[i].first;
+            values[i] = list[i].second;
+            for (size_t k = 0; k < i; ++k)
+                if (names[k] == names[i])
+                    throw std::logic_error{"choices: duplicate name"};
+            hashes[i] = internal::choice_hash(names[i]);
+            buckets[i] = internal::choice_mix(hashes[i], 0) & (bucket_count - 1);
+            ++sizes[buckets[i]];
+        }
+
+        // larger buckets are placed first, while most slots are free
+        for (auto n = N; n > 0; --n)
+            for (size_t b = 0; b < bucket_count; ++b)
+                if (sizes[b] == n && !place(hashes, buckets, b))
+                    throw std::logic_error{"choices: no perfect hash found"};
+    }
+
+private:
+    constexpr auto place(std::array<uint32_t, N> const& hashes,
+        std::array<size_t, N> const& buckets, size_t b) -> bool
+    {
+        for (uint32_t seed = 1; seed <= 0xffff; ++seed) {
+            auto ok = true;
+            for (size_t i = 0; i < N && ok; ++i) {
+                if (buckets[i] != b)
+                    continue;
+                auto& s = slots[internal::choice_mix(hashes[i], seed) & (table_size - 1)];
+                if (s) {
+                    // collision, clear the slots taken by this bucket so far
+                    for (size_t k = 0; k < i; ++k)
+                        if (buckets[k] == b)
+                            slots[internal::choice_mix(hashes[k], seed) & (table_size - 1)] = 0;
+                    ok = false;
+                }
+                else
+                    s = uint8_t(i + 1);
+            }
+            if (ok) {
+                seeds[b] = uint16_t(seed);
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+template <typename E, size_t N>
+constexpr auto make_choices(std::pair<char const*, E> const (&list)[N]) -> choices<E, N>
+{
+    return choices<E, N>{list};
+}
+
+// choice_target is the type-erased part of a choice, targets refer to it
+class choice_target {
+public:
+    // index of the name, npos when the name is not in the table
+    auto find(std::string_view s) const -> size_t
+    {
+        auto h = internal::choice_hash(s);
+        auto seed = seeds[internal::choice_mix(h, 0) & bucket_mask];
+        auto i = slots[internal::choice_mix(h, seed) & slot_mask];
+        return i && names[i - 1] == s ? size_t(i - 1) : std::string_view::npos;
+    }
+
+    auto allowed(std::string_view separator = "|") const -> std::string
+    {
+        auto ret = std::string{};
+        for (size_t i = 0; i < count; ++i) {
+            if (i)
+                ret += separator;
+            ret += names[i];
+        }
+        return ret;
+    }
+
+    auto size() const -> size_t { return count; }
+    auto name(size_t i) const -> std::string_view { return names[i]; }
+
+protected:
+    using assign_fn = void (*)(choice_target& self, size_t i);
+
+    void const* table;
+    std::string_view const* names;
+    uint16_t const* seeds;
+    uint8_t const* slots;
+    size_t count;
+    uint32_t bucket_mask;
+    uint32_t slot_mask;
+    assign_fn assign;
+
+    template <typename E, size_t N>
+    choice_target(choices<E, N> const& table, assign_fn assign)
+        : table{&table}
+        , names{table.names.data()}
+        , seeds{table.seeds.data()}
+        , slots{table.slots.data()}
+        , count{N}
+        , bucket_mask{uint32_t(table.bucket_count - 1)}
+        , slot_mask{uint32_t(table.table_size - 1)}
+        , assign{assign}
+    {
+    }
+
+    void write(std::string_view s)
+    {
+        auto i = find(s);
+        if (i == std::string_view::npos)
+            throw error{std::string{"invalid value '"} + std::string{s} +
+                        "', expected one of: " + allowed(", ")};
+        assign(*this, i);
+    }
+
+    friend struct target;
+};
+
+// choice is a target for one of the values of a choices table, the table
+// must outlive the choice
+template <typename E> class choice : public choice_target {
+public:
+    std::optional<E> value; // empty until parsed, unless initialized
+
+    template <size_t N>
+    explicit choice(choices<E, N> const& table, std::optional<E> initial = {})
+        : choice_target{table,
+              [](choice_target& self, size_t i) {
+                  auto& c = static_cast<choice&>(self);
+                  c.value = static_cast<choices<E, N> const*>(c.table)->values[i];
+              }}
+        , value{initial}
+    {
+    }
+
+    auto value_or(E def) const -> E { return value.value_or(def); }
+};
+
+} // namespace cli
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "error.hpp"
+
+namespace cli {
+
+// duplicates specifies how repeated keys are handled in a key_value_map
+enum class duplicates {
+    last_wins,
+    first_wins,
+    error,
+};
+
+// key_value_map is a multi-value target for repeated key=value flags
+// (-Dkey=value). Keys and values are packed into a single buffer while
+// parsing; once the command line is parsed, the pairs are sorted and
+// deduplicated in one pass into a flat, contiguous array of views.
+class key_value_map {
+public:
+    using value_type = std::pair<std::string_view, std::string_view>;
+    using const_iterator = std::vector<value_type>::const_iterator;
+
+    duplicates policy;
+
+    key_value_map(duplicates policy = duplicates::last_wins)
+        : policy{policy}
+    {
+    }
+
+    key_value_map(key_value_map const&) = delete;
+    auto operator=(key_value_map const&) -> key_value_map& = delete;
+
+    auto empty() const -> bool { return items.empty(); }
+    auto size() const -> size_t { return items.size(); }
+    auto begin() const -> const_iterator { return items.begin(); }
+    auto end() const -> const_iterator { return items.end(); }
+
+    auto find(std::string_view key) const -> std::optional<std::string_view>
+    {
+        auto it = std::lower_bound(items.begin(), items.end(), key,
+            [](value_type const& kv, std::string_view k) { return kv.first < k; });
+        if (it != items.end() && it->first == key)
+            return it->second;
+        return {};
+    }
+
+    auto contains(std::string_view key) const -> bool { return find(key).has_value(); }
+
+protected:
+    struct span {
+        size_t key_pos;
+        size_t key_len;
+        size_t value_pos;
+        size_t value_len;
+    };
+
+    std::string storage;
+    std::vector<span> pending;
+    std::vector<value_type> items; // sorted, views into storage
+
+    // records the token, a token without '=' defines a key with an empty value
+    void add(std::string_view token)
+    {
+        auto eq = token.find('=');
+        auto key = token.substr(0, eq);
+        if (key.empty())
+            throw error{std::string{"missing key in '"} + std::string{token} + "'"};
+        auto value = eq == std::string_view::npos ? std::string_view{} : token.substr(eq + 1);
+        if (!items.empty())
+            reopen();
+        pending.push_back({storage.size(), key.size(), storage.size() + key.size(), value.size()});
+        storage += key;
+        storage += value;
+    }
+
+    // sorts and deduplicates the pending pairs
+    void finish()
+    {
+        if (pending.empty())
+            return;
+        auto key = [this](span const& s) {
+            return std::string_view{storage}.substr(s.key_pos, s.key_len);
+        };
+        std::stable_sort(pending.begin(), pending.end(),
+            [&](span const& a, span const& b) { return key(a) < key(b); });
+
+        items.clear();
+        items.reserve(pending.size());
+        auto sv = std::string_view{storage};
+        for (auto b = pending.begin(); b != pending.end();) {
+            auto e = std::find_if(b + 1, pending.end(),
+                [&](span const& s) { return key(s) != key(*b); });
+            if (e - b > 1 && policy == duplicates::error)
+                throw error{std::string{"duplicate definition: "} + std::string{key(*b)}};
+            auto& s = policy == duplicates::first_wins ? *b : *(e - 1);
+            items.push_back(
+                {sv.substr(s.key_pos, s.key_len), sv.substr(s.value_pos, s.value_len)});
+            b = e;
+        }
+        pending.clear();
+    }
+
+    // converts sorted items back into pending spans before the storage grows
+    void reopen()
+    {
+        for (auto& [k, v] : items)
+            pending.push_back({size_t(k.data() - storage.data()), k.size(),
+                size_t(v.data() - storage.data()), v.size()});
+        items.clear();
+    }
+
+    friend struct target;
+};
+
+} // namespace cli
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+namespace cli {
+
+// metrics keeps usage counters for subcommands and flags and parse latency
+// histograms per subcommand path. Compiled in only when CLIXX_METRICS is
+// defined. Counters are relaxed atomics in a fixed-capacity lock-free hash
+// table, entries are never removed. Lookups probe at most max_probe slots,
+// so a crowded table drops new labels (counted in clixx_metrics_dropped_total)
+// instead of scanning the whole table on every parse.
+class metrics {
+public:
+    static constexpr size_t capacity = 4096;
+    static constexpr size_t max_probe = 32;
+
+    // histogram bucket upper bounds, in seconds
+    static constexpr std::array<double, 12> bounds = {
+        1e-6, 5e-6, 1e-5, 5e-5, 1e-4, 5e-4, 1e-3, 5e-3, 1e-2, 5e-2, 1e-1, 1.0};
+
+    struct entry {
+        std::string path; // subcommand path
+        std::string flag; // empty for subcommand entries
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> count{0}; // latency observations
+        std::atomic<uint64_t> sum_ns{0};
+        std::array<std::atomic<uint64_t>, bounds.size() + 1> buckets{}; // last one is +Inf
+    };
+
+    // when set, the counters are appended to this file in the destructor of
+    // the instance (at process exit), intended for one-shot command lines
+    std::filesystem::path spool_path;
+
+    static auto instance() -> metrics&
+    {
+        static auto m = metrics{};
+        return m;
+    }
+
+    ~metrics()
+    {
+        if (!spool_path.empty())
+            append(spool_path);
+        for (auto& s : slots)
+            delete s.load(std::memory_order_acquire);
+    }
+
+    // returns nullptr when no slot is free within max_probe slots
+    auto get(std::string_view path, std::string_view flag) -> entry*
+    {
+        auto h = hash(path, flag);
+        auto created = static_cast<entry*>(nullptr);
+        for (size_t probe = 0; probe < max_probe; ++probe) {
+            auto& slot = slots[(h + probe) % capacity];
+            auto e = slot.load(std::memory_order_acquire);
+            if (!e) {
+                if (!created) {
+                    created = new entry{};
+                    created->path = path;
+                    created->flag = flag;
+                }
+                if (slot.compare_exchange_strong(e, created, std::memory_order_acq_rel))
+                    return created;
+                // another thread took the slot, e is its entry
+            }
+            if (e->path == path && e->flag == flag) {
+                delete created;
+                return e;
+            }
+        }
+        delete created;
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    void hit(std::string_view path, std::string_view flag = {})
+    {
+        if (auto e = get(path, flag))
+            e->hits.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void observe(std::string_view path, std::chrono::nanoseconds dt)
+    {
+        auto e = get(path, {});
+        if (!e)
+            return;
+        auto secs = std::chrono::duration<double>(dt).count();
+        auto i = size_t{0};
+        while (i < bounds.size() && secs > bounds[i])
+            ++i;
+        e->buckets[i].fetch_add(1, std::memory_order_relaxed);
+        e->count.fetch_add(1, std::memory_order_relaxed);
+        e->sum_ns.fetch_add(uint64_t(dt.count()), std::memory_order_relaxed);
+    }
+
+    // writes all counters in Prometheus text exposition format
+    void write_prometheus(std::ostream& os) const
+    {
+        os << "# HELP clixx_subcommand_hits_total Number of times a subcommand was used.\n";
+        os << "# TYPE clixx_subcommand_hits_total counter\n";
+        for (auto& s : slots)
+            if (auto e = s.load(std::memory_order_acquire); e && e->flag.empty())
+                os << "clixx_subcommand_hits_total{path=\"" << escape(e->path) << "\"} "
+                   << e->hits.load(std::memory_order_relaxed) << '\n';
+
+        os << "# HELP clixx_flag_hits_total Number of times a flag was used.\n";
+        os << "# TYPE clixx_flag_hits_total counter\n";
+        for (auto& s : slots)
+            if (auto e = s.load(std::memory_order_acquire); e && !e->flag.empty())
+                os << "clixx_flag_hits_total{path=\"" << escape(e->path) << "\",flag=\""
+                   << escape(e->flag) << "\"} " << e->hits.load(std::memory_order_relaxed)
+                   << '\n';
+
+        os << "# HELP clixx_parse_seconds Command line parsing latency.\n";
+        os << "# TYPE clixx_parse_seconds histogram\n";
+        for (auto& s : slots) {
+            auto e = s.load(std::memory_order_acquire);
+            if (!e || !e->flag.empty() || !e->count.load(std::memory_order_relaxed))
+                continue;
+            auto label = "path=\"" + escape(e->path) + "\"";
+            auto cumulative = uint64_t{0};
+            for (size_t i = 0; i < bounds.size(); ++i) {
+                cumulative += e->buckets[i].load(std::memory_order_relaxed);
+                os << "clixx_parse_seconds_bucket{" << label << ",le=\"" << bounds[i] << "\"} "
+                   << cumulative << '\n';
+            }
+            cumulative += e->buckets[bounds.size()].load(std::memory_order_relaxed);
+            os << "clixx_parse_seconds_bucket{" << label << ",le=\"+Inf\"} " << cumulative
+               << '\n';
+            os << "clixx_parse_seconds_sum{" << label << "} "
+               << double(e->sum_ns.load(std::memory_order_relaxed)) * 1e-9 << '\n';
+            os << "clixx_parse_seconds_count{" << label << "} "
+               << e->count.load(std::memory_order_relaxed) << '\n';
+        }
+
+        os << "# HELP clixx_metrics_dropped_total Observations dropped for lack of a slot.\n";
+        os << "# TYPE clixx_metrics_dropped_total counter\n";
+        os << "clixx_metrics_dropped_total " << dropped.load(std::memory_order_relaxed) << '\n';
+    }
+
+    // replaces the file with the current counters (long-running processes)
+    auto dump(std::filesystem::path const& fn) const -> bool
+    {
+        auto tmp = fn;
+        tmp += ".tmp";
+        {
+            auto f = std::ofstream{tmp, std::ios::binary};
+            write_prometheus(f);
+            if (!f)
+                return false;
+        }
+        auto ec = std::error_code{};
+        std::filesystem::rename(tmp, fn, ec);
+        return !ec;
+    }
+
+    // appends the current counters to a spool file (one-shot processes),
+    // each run is preceded by a timestamp comment
+    auto append(std::filesystem::path const& fn) const -> bool
+    {
+        auto ss = std::ostringstream{};
+        auto now = std::chrono::system_clock::now().time_since_epoch();
+        ss << "# run " << std::chrono::duration_cast<std::chrono::milliseconds>(now).count()
+           << '\n';
+        write_prometheus(ss);
+        auto f = std::ofstream{fn, std::ios::binary | std::ios::app};
+        f << ss.str(); // a single write keeps concurrent runs from interleaving
+        return bool(f);
+    }
+
+private:
+    std::array<std::atomic<entry*>, capacity> slots{};
+    std::atomic<uint64_t> dropped{0};
+
+    metrics() = default;
+
+    static auto hash(std::string_view path, std::string_view flag) -> size_t
+    {
+        auto h = uint64_t{14695981039346656037ull};
+        for (auto c : path)
+            h = (h ^ uint8_t(c)) * 1099511628211ull;
+        h = (h ^ 0xff) * 1099511628211ull;
+        for (auto c : flag)
+            h = (h ^ uint8_t(c)) * 1099511628211ull;
+        return size_t(h);
+    }
+
+    static auto escape(std::string const& s) -> std::string
+    {
+        auto ret = std::string{};
+        for (auto c : s) {
+            if (c == '\\' || c == '"')
+                ret += '\\';
+            if (c == '\n') {
+                ret += "\\n";
+                continue;
+            }
+            ret += c;
+        }
+        return ret;
+    }
+};
+
+} // namespace cli
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#include <stdlib.h>
+#else
+#include <cstdlib>
+#include <unistd.h>
+#endif
+#ifdef __APPLE__
+#include <mach-o/dyld.h>
+#endif
+
+#include "error.hpp"
+
+namespace cli {
+
+// path_check specifies declarative checks that are applied to path targets
+// once the command line is parsed
+enum class path_check : unsigned {
+    none = 0,
+    exists = 1,
+    file = 2,      // must be a regular file
+    directory = 4, // must be a directory
+    readable = 8,  // must be readable by the current user
+};
+
+inline constexpr auto operator|(path_check a, path_check b) -> path_check
+{
+    return path_check(unsigned(a) | unsigned(b));
+}
+
+inline constexpr auto operator&(path_check a, path_check b) -> bool
+{
+    return (unsigned(a) & unsigned(b)) != 0;
+}
+
+// path_list is a multi-value target that collects file system paths
+struct path_list {
+    std::vector<std::filesystem::path> items;
+    path_check checks = path_check::none;
+
+    path_list(path_check checks = path_check::exists)
+        : checks{checks}
+    {
+    }
+};
+
+namespace internal {
+
+// returns nullptr when the path passes the checks, or a description of the
+// first failed check
+inline auto check_path(std::filesystem::path const& p, path_check checks) -> char const*
+{
+    if (checks == path_check::none)
+        return nullptr;
+
+    // one stat call serves exists, file, and directory checks
+    auto ec = std::error_code{};
+    auto st = std::filesystem::status(p, ec);
+    if (!std::filesystem::exists(st))
+        return "does not exist";
+    if ((checks & path_check::file) && !std::filesystem::is_regular_file(st))
+        return "not a file";
+    if ((checks & path_check::directory) && !std::filesystem::is_directory(st))
+        return "not a directory";
+    if (checks & path_check::readable) {
+#ifdef _WIN32
+        if (::_waccess(p.c_str(), 4) != 0)
+            return "not readable";
+#else
+        if (::access(p.c_str(), R_OK) != 0)
+            return "not readable";
+#endif
+    }
+    return nullptr;
+}
+
+// check_paths validates all paths collected by the targets as a single
+// batch, spreading the checks across a small pool of worker threads.
+// Throws an error that lists every path that fails its checks.
+inline void check_paths(std::vector<path_list const*> const& targets)
+{
+    struct job {
+        std::filesystem::path const* p;
+        path_check checks;
+    };
+
+    auto jobs = std::vector<job>{};
+    for (auto t : targets)
+        if (t->checks != path_check::none)
+            for (auto& p : t->items)
+                jobs.push_back({&p, t->checks});
+    if (jobs.empty())
+        return;
+
+    auto results = std::vector<char const*>(jobs.size(), nullptr);
+    auto next = std::atomic<size_t>{0};
+    auto worker = [&]() {
+        constexpr auto chunk = size_t{16};
+        for (;;) {
+            auto b = next.fetch_add(chunk, std::memory_order_relaxed);
+            if (b >= jobs.size())
+                return;
+            auto e = std::min(b + chunk, jobs.size());
+            for (auto i = b; i < e; ++i)
+                results[i] = check_path(*jobs[i].p, jobs[i].checks);
+        }
+    };
+
+    // small batches are not worth spinning up threads
+    auto nthreads = std::min<size_t>({std::max(1u, std::thread::hardware_concurrency()),
+        size_t{8}, (jobs.size() + 63) / 64});
+    auto threads = std::vector<std::thread>{};
+    for (size_t i = 1; i < nthreads; ++i)
+        threads.emplace_back(worker);
+    worker();
+    for (auto& t : threads)
+        t.join();
+
+    auto err_msg = std::string{};
+    auto nfailed = size_t{0};
+    for (size_t i = 0; i < jobs.size(); ++i)
+        if (results[i]) {
+            err_msg += "\n    ";
+            err_msg += jobs[i].p->string();
+            err_msg += ": ";
+            err_msg += results[i];
+            ++nfailed;
+        }
+    if (nfailed == 1)
+        throw error{std::string{"invalid path:"} + err_msg};
+    if (nfailed > 1)
+        throw error{std::string{"invalid paths:"} + err_msg};
+}
+
+// locates the running executable; argv0 is used when the platform does not
+// report it, a bare name (a program started from PATH) is looked up in PATH
+inline auto executable_file(std::filesystem::path const& argv0) -> std::filesystem::path
+{
+    namespace fs = std::filesystem;
+    auto ec = std::error_code{};
+#if defined(_WIN32)
+    wchar_t* pgm = nullptr;
+    if (::_get_wpgmptr(&pgm) == 0 && pgm && *pgm)
+        return fs::path{pgm};
+#elif defined(__APPLE__)
+    char buf[4096];
+    auto size = uint32_t(sizeof(buf));
+    if (::_NSGetExecutablePath(buf, &size) == 0)
+        return fs::weakly_canonical(buf, ec);
+#elif defined(__linux__)
+    auto self = fs::read_symlink("/proc/self/exe", ec);
+    if (!ec)
+        return self;
+    ec.clear();
+#endif
+    if (argv0.empty() || argv0.has_parent_path())
+        return argv0;
+    auto env = std::getenv("PATH");
+    auto dirs = std::string_view{env ? env : ""};
+#ifdef _WIN32
+    constexpr auto separator = ';';
+#else
+    constexpr auto separator = ':';
+#endif
+    while (!dirs.empty()) {
+        auto n = dirs.find(separator);
+        auto dir = dirs.substr(0, n);
+        dirs = n == std::string_view::npos ? std::string_view{} : dirs.substr(n + 1);
+        auto candidate = fs::path{dir.empty() ? "." : dir} / argv0;
+        if (fs::is_regular_file(candidate, ec))
+            return candidate;
+    }
+    return argv0;
+}
+
+} // namespace internal
+
+} // namespace cli
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cli {
+
+// thread_pool is a small work-stealing pool: each worker owns a deque, runs
+// its own tasks in LIFO order and steals from the other workers in FIFO
+// order when idle. Tasks posted from a worker go to that worker's deque.
+class thread_pool {
+public:
+    using task = std::function<void()>;
+
+    explicit thread_pool(unsigned nthreads = 0)
+    {
+        if (!nthreads)
+            nthreads = std::max(1u, std::thread::hardware_concurrency());
+        for (auto i = 0u; i < nthreads; ++i)
+            queues.push_back(std::make_unique<queue>());
+        for (auto i = 0u; i < nthreads; ++i)
+            threads.emplace_back([this, i]() { run(i); });
+    }
+
+    thread_pool(thread_pool const&) = delete;
+    auto operator=(thread_pool const&) -> thread_pool& = delete;
+
+    ~thread_pool()
+    {
+        wait();
+        {
+            auto lock = std::lock_guard{mtx};
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : threads)
+            t.join();
+    }
+
+    auto size() const -> size_t { return threads.size(); }
+
+    void post(task t)
+    {
+        auto i = current_pool == this ? current_index : next.fetch_add(1) % queues.size();
+        active.fetch_add(1);
+        {
+            auto lock = std::lock_guard{queues[i]->mtx};
+            queues[i]->tasks.push_back(std::move(t));
+        }
+        {
+            auto lock = std::lock_guard{mtx};
+            ++queued;
+        }
+        wake.notify_one();
+    }
+
+    // waits until all posted tasks (including tasks that they post) finish
+    void wait()
+    {
+        auto lock = std::unique_lock{mtx};
+        idle.wait(lock, [this]() { return active.load() == 0; });
+    }
+
+private:
+    struct queue {
+        std::mutex mtx;
+        std::deque<task> tasks;
+    };
+
+    std::vector<std::unique_ptr<queue>> queues;
+    std::vector<std::thread> threads;
+    std::mutex mtx; // guards queued and stopping
+    std::condition_variable wake;
+    std::condition_variable idle;
+    size_t queued = 0;
+    bool stopping = false;
+    std::atomic<size_t> active{0}; // posted and not yet finished
+    std::atomic<size_t> next{0};
+
+    inline static thread_local thread_pool* current_pool = nullptr;
+    inline static thread_local size_t current_index = 0;
+
+    auto pop(size_t i, task& t) -> bool
+    {
+        {
+            auto& own = *queues[i];
+            auto lock = std::lock_guard{own.mtx};
+            if (!own.tasks.empty()) {
+                t = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        for (size_t k = 1; k < queues.size(); ++k) {
+            auto& victim = *queues[(i + k) % queues.size()];
+            auto lock = std::lock_guard{victim.mtx};
+            if (!victim.tasks.empty()) {
+                t = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run(size_t i)
+    {
+        current_pool = this;
+        current_index = i;
+        for (;;) {
+            {
+                auto lock = std::unique_lock{mtx};
+                wake.wait(lock, [this]() { return stopping || queued > 0; });
+                if (!queued)
+                    return;
+                --queued;
+            }
+            // a task is reserved for this worker, it may be in any queue
+            auto t = task{};
+            while (!pop(i, t))
+                std::this_thread::yield();
+            t();
+            if (active.fetch_sub(1) == 1) {
+                auto lock = std::lock_guard{mtx};
+                idle.notify_all();
+            }
+        }
+    }
+};
+
+} // namespace cli
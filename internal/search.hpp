@@ -0,0 +1,228 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cli {
+
+// search_index is an inverted index over command paths, names, and
+// descriptions that serves 'help --search <terms>' queries
+class search_index {
+public:
+    struct doc {
+        std::string path; // subcommand path, empty for the root command
+        std::string desc; // short description
+    };
+
+    struct match {
+        size_t doc;
+        size_t nterms; // number of matched query terms
+        double score;
+    };
+
+    std::vector<doc> docs;
+
+    auto empty() const -> bool { return docs.empty(); }
+
+    auto add_doc(std::string const& path, std::string_view desc) -> uint32_t
+    {
+        auto d = std::string{desc};
+        std::replace(d.begin(), d.end(), '\t', ' ');
+        std::replace(d.begin(), d.end(), '\n', ' ');
+        docs.push_back({path, d});
+        return uint32_t(docs.size() - 1);
+    }
+
+    // add_text indexes all words in text as occurrences within the doc
+    void add_text(uint32_t doc_id, std::string_view text, uint32_t weight)
+    {
+        tokenize(text, [&](std::string&& term) {
+            pending.push_back({std::move(term), {doc_id, weight}});
+        });
+        sorted = false;
+    }
+
+    // query returns documents ranked by the number of matched terms, then by
+    // their tf-idf score; query terms also match as prefixes
+    auto query(std::string_view text, size_t limit = 20) -> std::vector<match>
+    {
+        finish();
+        auto scores = std::vector<match>(docs.size());
+        for (size_t i = 0; i < docs.size(); ++i)
+            scores[i] = {i, 0, 0.0};
+
+        tokenize(text, [&](std::string&& qt) {
+            auto doc_score = std::vector<double>(docs.size(), 0.0);
+            auto it = std::lower_bound(terms.begin(), terms.end(), qt,
+                [](entry const& e, std::string const& s) { return e.term < s; });
+            for (; it != terms.end() && it->term.compare(0, qt.size(), qt) == 0; ++it) {
+                auto idf = std::log(1.0 + double(docs.size()) / double(it->postings.size()));
+                // exact matches rank above prefix matches
+                auto exact = it->term.size() == qt.size() ? 2.0 : 1.0;
+                for (auto& p : it->postings)
+                    doc_score[p.doc] += exact * p.weight * idf;
+            }
+            for (size_t i = 0; i < docs.size(); ++i)
+                if (doc_score[i] > 0) {
+                    ++scores[i].nterms;
+                    scores[i].score += doc_score[i];
+                }
+        });
+
+        auto ret = std::vector<match>{};
+        for (auto& m : scores)
+            if (m.nterms)
+                ret.push_back(m);
+        std::stable_sort(ret.begin(), ret.end(), [](match const& a, match const& b) {
+            if (a.nterms != b.nterms)
+                return a.nterms > b.nterms;
+            return a.score > b.score;
+        });
+        if (ret.size() > limit)
+            ret.resize(limit);
+        return ret;
+    }
+
+    // save persists the index, build_id identifies the binary that the index
+    // was built for
+    auto save(std::filesystem::path const& fn, std::string const& build_id) -> bool
+    {
+        finish();
+        auto tmp = fn;
+        tmp += ".tmp";
+        {
+            auto f = std::ofstream{tmp, std::ios::binary};
+            if (!f)
+                return false;
+            f << signature << '\n' << build_id << '\n' << docs.size() << '\n';
+            for (auto& d : docs)
+                f << d.path << '\t' << d.desc << '\n';
+            f << terms.size() << '\n';
+            for (auto& e : terms) {
+                f << e.term << ' ' << e.postings.size();
+                for (auto& p : e.postings)
+                    f << ' ' << p.doc << ' ' << p.weight;
+                f << '\n';
+            }
+            if (!f)
+                return false;
+        }
+        auto ec = std::error_code{};
+        std::filesystem::rename(tmp, fn, ec);
+        if (ec)
+            std::filesystem::remove(tmp, ec);
+        return !ec;
+    }
+
+    // load reads a persisted index, fails if the index was built for another
+    // binary
+    auto load(std::filesystem::path const& fn, std::string const& build_id) -> bool
+    {
+        auto f = std::ifstream{fn, std::ios::binary};
+        auto line = std::string{};
+        if (!std::getline(f, line) || line != signature)
+            return false;
+        if (!std::getline(f, line) || line != build_id)
+            return false;
+
+        auto ndocs = size_t{0};
+        if (!(f >> ndocs) || !std::getline(f, line))
+            return false;
+        auto new_docs = std::vector<doc>{};
+        new_docs.reserve(ndocs);
+        for (size_t i = 0; i < ndocs; ++i) {
+            if (!std::getline(f, line))
+                return false;
+            auto tab = line.find('\t');
+            if (tab == std::string::npos)
+                return false;
+            new_docs.push_back({line.substr(0, tab), line.substr(tab + 1)});
+        }
+
+        auto nterms = size_t{0};
+        if (!(f >> nterms))
+            return false;
+        auto new_terms = std::vector<entry>(nterms);
+        for (auto& e : new_terms) {
+            auto n = size_t{0};
+            if (!(f >> e.term >> n))
+                return false;
+            e.postings.resize(n);
+            for (auto& p : e.postings)
+                if (!(f >> p.doc >> p.weight) || p.doc >= ndocs)
+                    return false;
+        }
+
+        docs = std::move(new_docs);
+        terms = std::move(new_terms);
+        pending.clear();
+        sorted = true;
+        return true;
+    }
+
+private:
+    static constexpr char const* signature = "clixx-search-index 1";
+
+    struct posting {
+        uint32_t doc;
+        uint32_t weight;
+    };
+
+    struct entry {
+        std::string term;
+        std::vector<posting> postings;
+    };
+
+    std::vector<entry> terms; // sorted by term
+    std::vector<std::pair<std::string, posting>> pending;
+    bool sorted = true;
+
+    template <typename F> static void tokenize(std::string_view text, F&& fn)
+    {
+        auto term = std::string{};
+        for (auto c : text) {
+            if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || (unsigned char)(c) >= 0x80)
+                term += c;
+            else if (c >= 'A' && c <= 'Z')
+                term += char(c - 'A' + 'a');
+            else if (!term.empty())
+                fn(std::move(term)), term.clear();
+        }
+        if (!term.empty())
+            fn(std::move(term));
+    }
+
+    void finish()
+    {
+        if (sorted)
+            return;
+        for (auto& e : terms)
+            for (auto& p : e.postings)
+                pending.push_back({e.term, p});
+        std::sort(pending.begin(), pending.end(), [](auto const& a, auto const& b) {
+            if (a.first != b.first)
+                return a.first < b.first;
+            return a.second.doc < b.second.doc;
+        });
+        terms.clear();
+        for (auto& [term, p] : pending) {
+            if (terms.empty() || terms.back().term != term)
+                terms.push_back({term, {}});
+            auto& ps = terms.back().postings;
+            if (!ps.empty() && ps.back().doc == p.doc)
+                ps.back().weight += p.weight;
+            else
+                ps.push_back(p);
+        }
+        pending.clear();
+        sorted = true;
+    }
+};
+
+} // namespace cli
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "error.hpp"
+
+namespace cli {
+
+// arg_stream is a multi-value target that is iterated lazily by the action.
+// Command line values are produced as is, except for '-' that streams items
+// from stdin and '@file' that streams items from a file. Items are read in
+// blocks and split at the delimiter ('\n' or '\0' for find -print0 input),
+// empty items are skipped. Yielded views point into a recycled buffer and
+// are valid until the next item is requested, memory use does not grow with
+// the input size. Reads return whatever is available, so items from a slow
+// pipe are handed out as they arrive.
+class arg_stream {
+public:
+    char delimiter;
+
+    explicit arg_stream(char delimiter = '\n', size_t block_size = 64 * 1024)
+        : delimiter{delimiter}
+        , block_size{block_size ? block_size : 1}
+    {
+    }
+
+    arg_stream(arg_stream const&) = delete;
+    auto operator=(arg_stream const&) -> arg_stream& = delete;
+
+    ~arg_stream() { close(); }
+
+    // command line values, as recorded by the parser
+    auto raw_list() const -> std::vector<std::string_view> const& { return tokens; }
+    auto used() const -> bool { return !tokens.empty(); }
+
+    // produces the next item, returns false at the end of the input
+    auto next(std::string_view& item) -> bool
+    {
+        for (;;) {
+            if (file) {
+                if (read_item(item)) {
+                    if (item.empty())
+                        continue;
+                    return true;
+                }
+                close();
+                continue;
+            }
+            if (token >= tokens.size())
+                return false;
+            auto tok = tokens[token++];
+            if (tok == "-")
+                open(stdin, false);
+            else if (tok.size() > 1 && tok[0] == '@') {
+                auto fn = std::string{tok.substr(1)};
+                auto f = std::fopen(fn.c_str(), "rb");
+                if (!f)
+                    throw error{"failed to open " + fn};
+                open(f, true);
+            }
+            else {
+                item = tok;
+                return true;
+            }
+        }
+    }
+
+    // single-pass input iterator
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::string_view const*;
+        using reference = std::string_view const&;
+
+        iterator() = default;
+
+        auto operator*() const -> reference { return item; }
+        auto operator->() const -> pointer { return &item; }
+
+        auto operator++() -> iterator&
+        {
+            if (!src->next(item))
+                src = nullptr;
+            return *this;
+        }
+
+        auto operator==(iterator const& other) const -> bool { return src == other.src; }
+        auto operator!=(iterator const& other) const -> bool { return src != other.src; }
+
+    private:
+        arg_stream* src = nullptr;
+        std::string_view item;
+
+        explicit iterator(arg_stream* src)
+            : src{src}
+        {
+            ++*this;
+        }
+
+        friend class arg_stream;
+    };
+
+    auto begin() -> iterator { return iterator{this}; }
+    auto end() -> iterator { return iterator{}; }
+
+protected:
+    std::vector<std::string_view> tokens;
+    size_t token = 0; // next token to produce
+
+    size_t block_size;
+    std::vector<char> buf; // allocated on first use, recycled between inputs
+    size_t pos = 0;        // start of the next item in buf
+    size_t filled = 0;
+    std::FILE* file = nullptr;
+    bool owned = false;
+    bool eof = false;
+
+    void open(std::FILE* f, bool owns)
+    {
+        file = f;
+        owned = owns;
+        eof = false;
+        pos = filled = 0;
+        if (buf.empty())
+            buf.resize(block_size);
+    }
+
+    void close()
+    {
+        if (file && owned)
+            std::fclose(file);
+        file = nullptr;
+    }
+
+    auto read_item(std::string_view& item) -> bool
+    {
+        for (;;) {
+            auto first = buf.data() + pos;
+            if (auto p = static_cast<char const*>(std::memchr(first, delimiter, filled - pos))) {
+                item = trim({first, size_t(p - first)});
+                pos += size_t(p - first) + 1;
+                return true;
+            }
+            if (eof) {
+                if (pos == filled)
+                    return false;
+                item = trim({first, filled - pos});
+                pos = filled;
+                return true;
+            }
+
+            // keep the partial item, grow the buffer only for items that do
+            // not fit into a single block
+            std::memmove(buf.data(), first, filled - pos);
+            filled -= pos;
+            pos = 0;
+            if (filled == buf.size())
+                buf.resize(buf.size() * 2);
+            auto n = read_some(buf.data() + filled, buf.size() - filled);
+            if (!n)
+                eof = true;
+            filled += n;
+        }
+    }
+
+    // unlike fread, returns as soon as some data is available
+    auto read_some(char* dst, size_t size) -> size_t
+    {
+        for (;;) {
+#ifdef _WIN32
+            auto n = ::_read(::_fileno(file), dst, unsigned(std::min<size_t>(size, 1u << 30)));
+#else
+            auto n = ::read(::fileno(file), dst, size);
+#endif
+            if (n >= 0)
+                return size_t(n);
+            if (errno != EINTR)
+                throw error{"failed to read arguments"};
+        }
+    }
+
+    // drops the CR of CRLF line endings
+    auto trim(std::string_view s) const -> std::string_view
+    {
+        if (delimiter == '\n' && !s.empty() && s.back() == '\r')
+            s.remove_suffix(1);
+        return s;
+    }
+
+    friend struct target;
+};
+
+} // namespace cli
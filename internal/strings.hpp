@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace cli {
+
+// string_pool interns strings into large arena blocks, interned views stay
+// valid for the lifetime of the pool. Equal strings are stored once, so
+// rebuilding a command node with the same schema does not allocate.
+class string_pool {
+public:
+    auto intern(std::string_view s) -> std::string_view
+    {
+        if (s.empty())
+            return {};
+        auto lock = std::lock_guard{mtx};
+        if (auto it = known.find(s); it != known.end())
+            return *it;
+        auto ret = store(s);
+        known.insert(ret);
+        return ret;
+    }
+
+    // bytes held by the arena blocks
+    auto capacity() const -> size_t
+    {
+        auto lock = std::lock_guard{mtx};
+        return allocated;
+    }
+
+private:
+    static constexpr size_t block_size = 64 * 1024;
+
+    mutable std::mutex mtx;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    std::vector<std::unique_ptr<char[]>> large;
+    size_t used = block_size; // in the last block
+    size_t allocated = 0;
+    std::unordered_set<std::string_view> known;
+
+    auto store(std::string_view s) -> std::string_view
+    {
+        if (s.size() > block_size / 4) {
+            // large strings get their own blocks
+            large.push_back(std::make_unique<char[]>(s.size()));
+            allocated += s.size();
+            std::memcpy(large.back().get(), s.data(), s.size());
+            return {large.back().get(), s.size()};
+        }
+        if (used + s.size() > block_size) {
+            blocks.push_back(std::make_unique<char[]>(block_size));
+            allocated += block_size;
+            used = 0;
+        }
+        auto p = blocks.back().get() + used;
+        std::memcpy(p, s.data(), s.size());
+        used += s.size();
+        return {p, s.size()};
+    }
+};
+
+namespace internal {
+
+// names, letters, and samples are used while parsing
+inline auto names() -> string_pool&
+{
+    static auto pool = string_pool{};
+    return pool;
+}
+
+// descriptions are only used for help and documentation
+inline auto descriptions() -> string_pool&
+{
+    static auto pool = string_pool{};
+    return pool;
+}
+
+inline auto name_hash(std::string_view s) -> uint32_t
+{
+    auto h = uint32_t{2166136261u};
+    for (auto c : s)
+        h = (h ^ uint8_t(c)) * 16777619u;
+    return h;
+}
+
+} // namespace internal
+
+} // namespace cli
@@ -1,18 +1,152 @@
 #pragma once
 
+#include <functional>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <variant>
-#include <optional>
+#include <vector>
+
+#include "choice.hpp"
+#include "kvmap.hpp"
+#include "path.hpp"
+#include "stream.hpp"
 
 namespace cli {
 
+// lazy_token records raw command line tokens of a flag or an argument, the
+// conversion is deferred until the value is accessed. Recorded tokens
+// point to the command line storage and must not outlive it.
+class lazy_token {
+public:
+    auto used() const -> bool { return !tokens.empty(); }
+
+    // the last recorded token
+    auto raw() const -> std::string_view
+    {
+        return tokens.empty() ? std::string_view{} : tokens.back();
+    }
+
+    // all recorded tokens (multi-value targets)
+    auto raw_list() const -> std::vector<std::string_view> const& { return tokens; }
+
+protected:
+    std::vector<std::string_view> tokens;
+    bool multi = false;
+    unsigned version = 0; // bumped whenever the tokens change, invalidates caches
+
+    explicit lazy_token(bool multi)
+        : multi{multi}
+    {
+    }
+
+    friend struct target;
+};
+
+// lazy is a single-value target converted on first access by get()
+template <typename T> class lazy : public lazy_token {
+public:
+    using converter = std::function<T(std::string_view)>;
+
+    lazy()
+        : lazy_token{false}
+        , conv{[](std::string_view s) { return T(s); }}
+    {
+    }
+
+    explicit lazy(converter conv)
+        : lazy_token{false}
+        , conv{conv}
+    {
+    }
+
+    auto get() const -> T const&
+    {
+        if (!cache || cached != version) {
+            cache = conv(raw());
+            cached = version;
+        }
+        return *cache;
+    }
+
+    auto value_or(T const& def) const -> T { return used() ? get() : def; }
+
+private:
+    converter conv;
+    mutable std::optional<T> cache;
+    mutable unsigned cached = 0;
+};
+
+// lazy_list is a multi-value target converted on first access by get()
+template <typename T> class lazy_list : public lazy_token {
+public:
+    using converter = std::function<T(std::string_view)>;
+
+    lazy_list()
+        : lazy_token{true}
+        , conv{[](std::string_view s) { return T(s); }}
+    {
+    }
+
+    explicit lazy_list(converter conv)
+        : lazy_token{true}
+        , conv{conv}
+    {
+    }
+
+    auto get() const -> std::vector<T> const&
+    {
+        if (!cache || cached != version) {
+            auto ret = std::vector<T>{};
+            ret.reserve(tokens.size());
+            for (auto& tok : tokens)
+                ret.push_back(conv(tok));
+            cache = std::move(ret);
+            cached = version;
+        }
+        return *cache;
+    }
+
+private:
+    converter conv;
+    mutable std::optional<std::vector<T>> cache;
+    mutable unsigned cached = 0;
+};
+
+// passthrough receives the arguments that follow the '--' terminator as is,
+// without parsing or copying. When the command line comes from main's argv,
+// argv() exposes the tail of the original (null-terminated) array that can
+// be handed to execvp directly.
+class passthrough {
+public:
+    auto empty() const -> bool { return first == last; }
+    auto size() const -> size_t { return size_t(last - first); }
+    auto begin() const -> std::string_view const* { return first; }
+    auto end() const -> std::string_view const* { return last; }
+
+    // returns nullptr when the original argv is not available
+    auto argv() const -> char* const* { return raw; }
+
+protected:
+    std::string_view const* first = nullptr;
+    std::string_view const* last = nullptr;
+    char* const* raw = nullptr;
+
+    friend struct target;
+};
+
 using target_ref = std::variant<                        //
     std::reference_wrapper<bool>,                       // boolean flag
     std::reference_wrapper<std::optional<bool>>,        // boolean flag
     std::reference_wrapper<std::string>,                // string option
     std::reference_wrapper<std::optional<std::string>>, // string option
-    std::reference_wrapper<std::vector<std::string>>    // string list option
+    std::reference_wrapper<std::vector<std::string>>,   // string list option
+    std::reference_wrapper<lazy_token>,                 // deferred conversion
+    std::reference_wrapper<path_list>,                  // validated path list
+    std::reference_wrapper<passthrough>,                // arguments after '--'
+    std::reference_wrapper<key_value_map>,              // key=value definitions
+    std::reference_wrapper<arg_stream>,                 // streamed values
+    std::reference_wrapper<choice_target>               // enum values
     >;
 
 struct target : public target_ref {
@@ -44,6 +178,42 @@ struct target : public target_ref {
     {
     }
 
+    target(lazy_token& v, bool required = false)
+        : target_ref{v}
+        , required{required}
+    {
+    }
+
+    target(path_list& v, bool required = true)
+        : target_ref{v}
+        , required{required}
+    {
+    }
+
+    target(key_value_map& v, bool required = false)
+        : target_ref{v}
+        , required{required}
+    {
+    }
+
+    target(passthrough& v, bool required = false)
+        : target_ref{v}
+        , required{required}
+    {
+    }
+
+    target(arg_stream& v, bool required = true)
+        : target_ref{v}
+        , required{required}
+    {
+    }
+
+    target(choice_target& v, bool required = false)
+        : target_ref{v}
+        , required{required}
+    {
+    }
+
     auto is_bool() const -> bool
     {
         return std::holds_alternative<std::reference_wrapper<bool>>(*this) ||
@@ -53,8 +223,13 @@ struct target : public target_ref {
 
     auto is_vector() const -> bool
     {
+        if (auto v = std::get_if<std::reference_wrapper<lazy_token>>(this))
+            return v->get().multi;
         return std::holds_alternative<
-            std::reference_wrapper<std::vector<std::string>>>(*this);
+                   std::reference_wrapper<std::vector<std::string>>>(*this) ||
+               std::holds_alternative<std::reference_wrapper<path_list>>(*this) ||
+               std::holds_alternative<std::reference_wrapper<key_value_map>>(*this) ||
+               std::holds_alternative<std::reference_wrapper<arg_stream>>(*this);
     }
 
     void write(bool value)
@@ -104,6 +279,106 @@ struct target : public target_ref {
                      std::reference_wrapper<std::vector<std::string>>>(this)) {
             v->get().push_back(std::string{value});
         }
+        else if (auto v = std::get_if<std::reference_wrapper<lazy_token>>(this)) {
+            auto& lt = v->get();
+            if (!lt.multi)
+                lt.tokens.clear();
+            lt.tokens.push_back(value);
+            ++lt.version;
+        }
+        else if (auto v = std::get_if<std::reference_wrapper<path_list>>(this)) {
+            v->get().items.emplace_back(value);
+        }
+        else if (auto v = std::get_if<std::reference_wrapper<key_value_map>>(this)) {
+            v->get().add(value);
+        }
+        else if (auto v = std::get_if<std::reference_wrapper<arg_stream>>(this)) {
+            v->get().tokens.push_back(value);
+        }
+        else if (auto v = std::get_if<std::reference_wrapper<choice_target>>(this)) {
+            v->get().write(value);
+        }
+    }
+
+    // discards the values recorded by a previous parse
+    void reset()
+    {
+        if (auto v = std::get_if<std::reference_wrapper<lazy_token>>(this)) {
+            auto& lt = v->get();
+            lt.tokens.clear();
+            ++lt.version;
+        }
+        else if (auto v = std::get_if<std::reference_wrapper<path_list>>(this)) {
+            v->get().items.clear();
+        }
+        else if (auto v = std::get_if<std::reference_wrapper<key_value_map>>(this)) {
+            auto& kv = v->get();
+            kv.storage.clear();
+            kv.pending.clear();
+            kv.items.clear();
+        }
+        else if (auto v = std::get_if<std::reference_wrapper<arg_stream>>(this)) {
+            auto& as = v->get();
+            as.close();
+            as.tokens.clear();
+            as.token = 0;
+            as.pos = as.filled = 0;
+        }
+    }
+
+    // completes the target once the command line is parsed
+    void finish()
+    {
+        if (auto v = std::get_if<std::reference_wrapper<key_value_map>>(this))
+            v->get().finish();
+    }
+
+    // target kind, as used in schema exports
+    auto kind() const -> char const*
+    {
+        // in the order of target_ref alternatives
+        static char const* const names[] = {
+            "bool", "bool", "string", "string", "list", "lazy", "paths", "passthrough", "map",
+            "stream", "choice"};
+        static_assert(std::size(names) == std::variant_size_v<target_ref>);
+        if (auto v = std::get_if<std::reference_wrapper<lazy_token>>(this))
+            return v->get().multi ? "lazy_list" : "lazy";
+        return names[index()];
+    }
+
+    auto is_map() const -> bool
+    {
+        return std::holds_alternative<std::reference_wrapper<key_value_map>>(*this);
+    }
+
+    auto is_passthrough() const -> bool
+    {
+        return std::holds_alternative<std::reference_wrapper<passthrough>>(*this);
+    }
+
+    void write_tail(
+        std::string_view const* first, std::string_view const* last, char* const* raw)
+    {
+        if (auto v = std::get_if<std::reference_wrapper<passthrough>>(this)) {
+            auto& pt = v->get();
+            pt.first = first;
+            pt.last = last;
+            pt.raw = raw;
+        }
+    }
+
+    auto paths() const -> path_list const*
+    {
+        if (auto v = std::get_if<std::reference_wrapper<path_list>>(this))
+            return &v->get();
+        return nullptr;
+    }
+
+    auto choices() const -> choice_target const*
+    {
+        if (auto v = std::get_if<std::reference_wrapper<choice_target>>(this))
+            return &v->get();
+        return nullptr;
     }
 };
 
@@ -0,0 +1,172 @@
+#include "../cli++.hpp"
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+// a minimal thread pool that serves as an executor
+struct thread_pool {
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<std::function<void()>> tasks;
+    std::vector<std::thread> workers;
+    bool stopping = false;
+
+    explicit thread_pool(unsigned n)
+    {
+        for (auto i = 0u; i < n; ++i)
+            workers.emplace_back([this]() {
+                for (;;) {
+                    auto task = std::function<void()>{};
+                    {
+                        auto lock = std::unique_lock{mtx};
+                        cv.wait(lock, [this]() { return stopping || !tasks.empty(); });
+                        if (tasks.empty())
+                            return;
+                        task = std::move(tasks.front());
+                        tasks.pop_front();
+                    }
+                    task();
+                }
+            });
+    }
+
+    ~thread_pool()
+    {
+        {
+            auto lock = std::lock_guard{mtx};
+            stopping = true;
+        }
+        cv.notify_all();
+        for (auto& w : workers)
+            w.join();
+    }
+
+    void post(std::function<void()> task)
+    {
+        {
+            auto lock = std::lock_guard{mtx};
+            tasks.push_back(std::move(task));
+        }
+        cv.notify_one();
+    }
+};
+
+struct job {
+    std::string name;
+    std::optional<bool> fast;
+    std::string result;
+    cli::app cl{"job", "async job"};
+
+    job()
+    {
+        cl.subcommand("fetch", "fetch an object", [this](cli::command& cmd) {
+            cmd.flag(fast, "fast", "f", "skip verification");
+            cmd.arg(name, "NAME", "object name");
+        });
+    }
+};
+
+auto main() -> int
+{
+    auto pool = thread_pool{4};
+    auto ex = cli::app::executor{[&pool](std::function<void()> task) { pool.post(task); }};
+
+    constexpr auto njobs = 200;
+    auto jobs = std::vector<std::unique_ptr<job>>{};
+    auto results = std::vector<std::future<void>>{};
+    for (auto i = 0; i < njobs; ++i) {
+        auto& j = *jobs.emplace_back(std::make_unique<job>());
+        auto cmdline = std::vector<std::string>{"job", "fetch", "obj" + std::to_string(i)};
+        if (i % 2)
+            cmdline.push_back("--fast");
+        if (i % 10 == 0)
+            cmdline.push_back("--unknown");
+        results.push_back(j.cl.execute_async(cmdline, ex));
+    }
+
+    auto failed = 0;
+    for (auto i = 0; i < njobs; ++i) {
+        try {
+            results[i].get();
+            if (i % 10 == 0) {
+                printf("job %d: expected an error\n", i);
+                ++failed;
+            }
+            else if (jobs[i]->name != "obj" + std::to_string(i) ||
+                     jobs[i]->fast.value_or(false) != bool(i % 2)) {
+                printf("job %d: unexpected parse result\n", i);
+                ++failed;
+            }
+        }
+        catch (cli::error const& e) {
+            if (i % 10 != 0) {
+                printf("job %d: %s\n", i, e.what());
+                ++failed;
+            }
+        }
+    }
+
+    // asynchronous action: completion is signalled from another task
+    auto counter = std::atomic<int>{0};
+    auto cl = cli::app{"counter", "async action"};
+    cl.async_action = [&](cli::command::completion done) {
+        pool.post([&counter, done]() {
+            ++counter;
+            done(nullptr);
+        });
+    };
+    auto f = cl.execute_async({"counter"}, ex);
+    f.get();
+    if (counter != 1) {
+        printf("async action did not run\n");
+        ++failed;
+    }
+
+    // errors thrown by asynchronous actions are reported via completion
+    auto failing = cli::app{"failing", "failing action"};
+    failing.async_action = [&](cli::command::completion done) {
+        pool.post([done]() { done(std::make_exception_ptr(cli::error{"action failed"})); });
+    };
+    try {
+        failing.execute_async({"failing"}, ex).get();
+        printf("action error was not reported\n");
+        ++failed;
+    }
+    catch (cli::error const&) {
+    }
+
+    // values owned by a subcommand node stay alive until the completion runs
+    struct sentinel {
+        std::atomic<bool>& destroyed;
+        explicit sentinel(std::atomic<bool>& destroyed)
+            : destroyed{destroyed}
+        {
+        }
+        ~sentinel() { destroyed = true; }
+    };
+    auto destroyed = std::atomic<bool>{false};
+    auto owner = cli::app{"owner", "node-owned targets"};
+    auto seen = std::string{};
+    owner.subcommand("later", "run later", [&](cli::command& cmd) {
+        auto& name = cmd.make<std::string>();
+        auto& guard = cmd.make<sentinel>(destroyed);
+        cmd.arg(name, "NAME", "object name");
+        cmd.async_action = [&](cli::command::completion done) {
+            pool.post([&, done]() {
+                seen = destroyed ? "destroyed" : name;
+                (void)guard;
+                done(nullptr);
+            });
+        };
+    });
+    owner.execute_async({"owner", "later", "obj"}, ex).get();
+    if (seen != "obj") {
+        printf("node-owned target was released early: %s\n", seen.c_str());
+        ++failed;
+    }
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,148 @@
+#include "../cli++.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+auto failed = 0;
+
+void check(bool ok, char const* what)
+{
+    if (!ok) {
+        printf("failed: %s\n", what);
+        ++failed;
+    }
+}
+
+enum class format { json, csv, table };
+constexpr auto formats = cli::make_choices<format>(
+    {{"json", format::json}, {"csv", format::csv}, {"table", format::table}});
+
+auto verbose = std::optional<bool>{};
+auto quiet = std::optional<bool>{};
+auto name = std::optional<std::string>{};
+auto output = std::optional<std::string>{};
+auto includes = std::vector<std::string>{};
+auto fmt = cli::choice<format>{formats};
+auto builds = 0; // subcommand callback invocations
+
+void setup(cli::app& a)
+{
+    a.flag(verbose, "verbose", "v", "verbose");
+    a.flag(quiet, "quiet", "q", "quiet");
+    a.flag({includes, false}, "include", "I", "include directory", "dir");
+    a.subcommand("remote", "manage remotes", [](cli::command& cmd) {
+        ++builds;
+        cmd.flag(name, "name", "", "remote name", "name");
+        cmd.flag(output, "", "o", "output file", "file");
+        cmd.flag(fmt, "format", "f", "output format");
+        cmd.subcommand("add", "add a remote", [](cli::command&) { ++builds; });
+        cmd.subcommand("remove", "remove a remote", [](cli::command&) { ++builds; });
+    });
+}
+
+auto has(std::vector<std::string> const& v, std::string const& s) -> bool
+{
+    return std::find(v.begin(), v.end(), s) != v.end();
+}
+
+void resume()
+{
+    auto a = cli::app{"git", "cursor test"};
+    setup(a);
+    auto c = cli::cursor{a};
+
+    c.update({"remote"});
+    check(builds == 1 && c.current().path == "remote", "subcommand node");
+
+    // editing the last token resumes from the cached prefix
+    c.update({"remote", "ad"});
+    c.update({"remote", "add"});
+    check(builds == 2 && c.current().path == "remote add", "nested subcommand node");
+    c.update({"remote", "add", "-v"});
+    auto used = c.current().used.get();
+    c.update({"remote", "add", "-v", "x"});
+    c.update({"remote", "add", "-v"});
+    check(c.current().used.get() == used, "cached states are reused");
+    c.update({"remote"});
+    check(c.complete("re") == std::vector<std::string>{"remove"}, "subcommand candidates");
+    c.update({"remote", "add", "-q"});
+    check(builds == 2, "subcommand callbacks are not run again");
+    check(!verbose && !name, "targets are not written");
+}
+
+void pending_values()
+{
+    auto a = cli::app{"git", "cursor test"};
+    setup(a);
+    auto c = cli::cursor{a};
+
+    c.update({"remote", "--name"});
+    check(c.current().pending && c.current().pending->name == "name", "--flag waits");
+    c.update({"remote", "--name", "origin"});
+    check(!c.current().pending && c.current().positional == 0, "--flag value");
+    c.update({"remote", "--name=origin"});
+    check(!c.current().pending, "--flag=value");
+
+    c.update({"remote", "-o"});
+    check(c.current().pending && c.current().pending->letters == "o", "-o waits");
+    c.update({"remote", "-o", "file"});
+    check(!c.current().pending && c.current().positional == 0, "-o value");
+
+    c.update({"remote", "-f"});
+    check(c.complete("") == std::vector<std::string>{"json", "csv", "table"}, "choice values");
+    check(c.complete("c") == std::vector<std::string>{"csv"}, "choice prefix");
+    c.update({"remote", "--format"});
+    check(c.complete("t") == std::vector<std::string>{"table"}, "choice of a long flag");
+}
+
+void termination()
+{
+    auto a = cli::app{"git", "cursor test"};
+    setup(a);
+    auto c = cli::cursor{a};
+
+    c.update({"--", "-v", "remote"});
+    auto& st = c.current();
+    check(st.terminated && st.positional == 2, "'--' ends flags");
+    check(!st.used && st.path.empty(), "tail is positional");
+    check(c.complete("-").empty() && c.complete("re").empty(), "no candidates after '--'");
+}
+
+void used_flags()
+{
+    auto a = cli::app{"git", "cursor test"};
+    setup(a);
+    auto c = cli::cursor{a};
+
+    auto all = c.complete("-");
+    check(has(all, "--verbose") && has(all, "--quiet") && has(all, "--include"), "flags");
+
+    c.update({"-v", "-I", "a"});
+    auto left = c.complete("--");
+    check(!has(left, "--verbose") && has(left, "--quiet"), "used flag drops out");
+    check(has(left, "--include"), "used vector flag stays");
+
+    c.update({"-qv"});
+    left = c.complete("--");
+    check(!has(left, "--verbose") && !has(left, "--quiet"), "folded flags drop out");
+
+    // parent flags are offered in subcommands
+    c.update({"remote"});
+    left = c.complete("-");
+    check(has(left, "--verbose") && has(left, "--name") && has(left, "-o"), "subcommand flags");
+}
+
+} // namespace
+
+auto main() -> int
+{
+    resume();
+    pending_values();
+    termination();
+    used_flags();
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,18 @@
+#include "../cli++.hpp"
+
+// schema shared by the help table test and its generator
+void clixx_schema(cli::app& a)
+{
+    static std::optional<bool> verbose;
+    a.desc = "help table test";
+    a.help_cmd = "help";
+    a.flag(verbose, "verbose", "v", "verbose output");
+    a.subcommand("check", "check a thing", [](cli::command& cmd) {
+        static std::string what;
+        cmd.arg(what, "WHAT", "thing to check");
+        cmd.subcommand("deep", "check a thing thoroughly", [](cli::command& cmd) {
+            static std::optional<std::string> level;
+            cmd.flag(level, "level", "l", "check level", "n");
+        });
+    });
+}
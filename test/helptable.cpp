@@ -0,0 +1,54 @@
+#include "../cli++.hpp"
+#include "helptable_help.hpp"
+#include <cstdio>
+#include <cstdlib>
+
+void clixx_schema(cli::app& a);
+
+namespace {
+
+auto help_text(char const* exe, std::vector<std::string_view> const& args, bool use_table)
+    -> std::string
+{
+    auto a = cli::app{""};
+    clixx_schema(a);
+    if (use_table)
+        a.use_help_table(helptable_help::help_table);
+    auto cmdline = std::vector<std::string_view>{exe};
+    cmdline.insert(cmdline.end(), args.begin(), args.end());
+    try {
+        a.execute(cmdline.data(), cmdline.data() + cmdline.size());
+    }
+    catch (cli::help const& msg) {
+        return msg.what();
+    }
+    return {};
+}
+
+} // namespace
+
+auto main(int argc, char* argv[]) -> int
+{
+    auto exe = argc > 0 ? argv[0] : "cli++test-helptable";
+    auto name = std::filesystem::path{exe}.filename().replace_extension("").string();
+
+    auto failed = 0;
+    auto cases = std::vector<std::vector<std::string_view>>{
+        {"--help"}, {"help"}, {"help", "check"}, {"--help", "check"}, {"help", "check", "deep"}};
+    for (auto& args : cases) {
+        auto runtime = help_text(exe, args, false);
+        auto table = help_text(exe, args, true);
+        if (runtime.empty() || runtime != table) {
+            printf("help table differs from runtime help:\n%s\n---\n%s\n", runtime.c_str(),
+                table.c_str());
+            ++failed;
+        }
+        if (table.find("    " + name + " ") == std::string::npos) {
+            printf("help table does not mention '%s':\n%s\n", name.c_str(), table.c_str());
+            ++failed;
+        }
+    }
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,113 @@
+#include "../cli++.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+auto failed = 0;
+
+void check(bool ok, char const* what)
+{
+    if (!ok) {
+        printf("failed: %s\n", what);
+        ++failed;
+    }
+}
+
+auto contains(std::string const& s, std::string const& what) -> bool
+{
+    return s.find(what) != std::string::npos;
+}
+
+auto prometheus() -> std::string
+{
+    auto ss = std::ostringstream{};
+    cli::metrics::instance().write_prometheus(ss);
+    return ss.str();
+}
+
+auto read_file(std::filesystem::path const& fn) -> std::string
+{
+    auto ss = std::ostringstream{};
+    ss << std::ifstream{fn, std::ios::binary}.rdbuf();
+    return ss.str();
+}
+
+void counters()
+{
+    static auto verbose = std::optional<bool>{};
+    auto cl = cli::app{"tool", "metrics test"};
+    cl.subcommand("build", "build things", [](cli::command& cmd) {
+        cmd.flag(verbose, "verbose", "v", "verbose");
+        cmd.action = []() {};
+    });
+    cl.execute({"tool", "build", "--verbose"});
+    cl.execute({"tool", "build", "-v"});
+    cli::metrics::instance().hit("a\"b");
+
+    auto text = prometheus();
+    check(contains(text, "# TYPE clixx_subcommand_hits_total counter\n"), "counter type");
+    check(contains(text, "clixx_subcommand_hits_total{path=\"tool\"} 2\n"), "root hits");
+    check(contains(text, "clixx_subcommand_hits_total{path=\"tool build\"} 2\n"),
+        "subcommand hits");
+    check(contains(text, "clixx_flag_hits_total{path=\"tool build\",flag=\"--verbose\"} 2\n"),
+        "flag hits");
+    check(contains(text, "# TYPE clixx_parse_seconds histogram\n"), "histogram type");
+    check(contains(text, "clixx_parse_seconds_bucket{path=\"tool build\",le=\"+Inf\"} 2\n"),
+        "histogram buckets");
+    check(contains(text, "clixx_parse_seconds_count{path=\"tool build\"} 2\n"),
+        "histogram count");
+    check(contains(text, "clixx_subcommand_hits_total{path=\"a\\\"b\"} 1\n"), "label escapes");
+    check(contains(text, "clixx_metrics_dropped_total 0\n"), "nothing dropped");
+}
+
+void files()
+{
+    auto& m = cli::metrics::instance();
+    auto fn = std::filesystem::temp_directory_path() / "clixx-test-metrics.prom";
+    std::filesystem::remove(fn);
+
+    // dump replaces the file
+    check(m.dump(fn) && m.dump(fn), "dump");
+    check(read_file(fn) == prometheus(), "dumped counters");
+
+    // append adds a run per call
+    std::filesystem::remove(fn);
+    check(m.append(fn) && m.append(fn), "append");
+    auto text = read_file(fn);
+    auto runs = 0;
+    for (auto p = text.find("# run "); p != std::string::npos; p = text.find("# run ", p + 1))
+        ++runs;
+    auto last = prometheus();
+    check(runs == 2 && text.size() > 2 * last.size() &&
+              text.compare(text.size() - last.size(), last.size(), last) == 0,
+        "appended runs");
+    std::filesystem::remove(fn);
+}
+
+void crowding()
+{
+    // labels that find no free slot within the probe limit are dropped
+    auto& m = cli::metrics::instance();
+    for (size_t i = 0; i < cli::metrics::capacity + 100; ++i)
+        m.hit("path " + std::to_string(i));
+    m.hit("tool");
+    auto text = prometheus();
+    check(!contains(text, "clixx_metrics_dropped_total 0\n"), "dropped labels are counted");
+    check(contains(text, "clixx_subcommand_hits_total{path=\"tool\"} 3\n"),
+        "existing labels are still counted");
+}
+
+} // namespace
+
+auto main() -> int
+{
+    counters();
+    files();
+    crowding();
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
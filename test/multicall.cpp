@@ -0,0 +1,88 @@
+#include "../cli++.hpp"
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+auto failed = 0;
+
+void check(bool ok, char const* what)
+{
+    if (!ok) {
+        printf("failed: %s\n", what);
+        ++failed;
+    }
+}
+
+auto ran = std::string{};
+auto all = std::optional<bool>{};
+
+auto reg_ls = cli::register_tool{"ls", "list files", [](cli::app& a) {
+    a.flag(all, "all", "a", "show hidden files");
+    a.action = []() { ran = "ls"; };
+}};
+
+auto reg_mkfs = cli::register_tool{"mkfs.ext4", "create a file system", [](cli::app& a) {
+    a.action = []() { ran = "mkfs.ext4"; };
+}};
+
+// runs the command line, returns the error or help message (empty on success)
+auto run(std::initializer_list<std::string_view> cmdline) -> std::string
+{
+    ran.clear();
+    all.reset();
+    try {
+        cli::multicall::execute(cmdline);
+    }
+    catch (cli::help const& e) {
+        return e.what();
+    }
+    catch (cli::error const& e) {
+        return std::string{"error: "} + e.what();
+    }
+    return {};
+}
+
+void symlinks()
+{
+    check(run({"/usr/bin/ls", "-a"}).empty() && ran == "ls" && all == true, "ls symlink");
+    check(run({"sbin/mkfs.ext4"}).empty() && ran == "mkfs.ext4", "name with a dot");
+    check(run({"ls.exe"}).empty() && ran == "ls", ".exe suffix");
+}
+
+void fallback()
+{
+    check(run({"multi", "ls", "-a"}).empty() && ran == "ls" && all == true, "multi ls");
+    check(run({"multi", "mkfs.ext4"}).empty() && ran == "mkfs.ext4", "multi mkfs.ext4");
+
+    auto list = run({"bin/multi"});
+    check(list.find("multi <tool> ...") != std::string::npos &&
+              list.find("mkfs.ext4") != std::string::npos,
+        "tool list");
+    check(run({"multi", "--help"}) == list, "multi --help");
+    check(run({"multi", "cp"}) == "error: unknown tool: cp", "unknown tool");
+}
+
+void duplicates()
+{
+    auto thrown = false;
+    try {
+        cli::multicall::add("ls", "list files again", {});
+    }
+    catch (std::logic_error const&) {
+        thrown = true;
+    }
+    check(thrown && cli::multicall::registry().size() == 2, "duplicate tool name");
+}
+
+} // namespace
+
+auto main() -> int
+{
+    symlinks();
+    fallback();
+    duplicates();
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
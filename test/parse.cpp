@@ -0,0 +1,247 @@
+#include "../cli++.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+namespace {
+
+auto failed = 0;
+
+void check(bool ok, char const* what)
+{
+    if (!ok) {
+        printf("failed: %s\n", what);
+        ++failed;
+    }
+}
+
+// runs the command line, returns the error message (empty on success)
+auto run(cli::app& cl, std::initializer_list<std::string_view> cmdline) -> std::string
+{
+    try {
+        cl.execute(cmdline);
+    }
+    catch (cli::error const& e) {
+        return e.what();
+    }
+    return {};
+}
+
+void attached_values()
+{
+    auto defines = cli::key_value_map{};
+    auto out = std::optional<std::string>{};
+    auto cl = cli::app{"attached"};
+    cl.flag(defines, "define", "D", "define a macro", "key=value");
+    cl.flag(out, "output", "o", "output file", "file");
+
+    check(run(cl, {"t", "-DA=1", "-D", "B=2", "--define=C"}).empty(), "key=value forms");
+    check(defines.size() == 3 && defines.find("A") == "1" && defines.find("B") == "2" &&
+              defines.contains("C") && defines.find("C")->empty(),
+        "key=value contents");
+
+    check(run(cl, {"t", "-o=file"}).empty() && out == "file", "-o=file");
+    check(run(cl, {"t", "-o", "file"}).empty() && out == "file", "-o file");
+    check(!run(cl, {"t", "-ofile"}).empty(), "-ofile is rejected");
+}
+
+void foldings()
+{
+    auto a = std::optional<bool>{};
+    auto b = std::optional<bool>{};
+    auto out = std::optional<std::string>{};
+    auto cl = cli::app{"foldings"};
+    cl.flag(a, "alpha", "a", "a");
+    cl.flag(b, "beta", "b", "b");
+    cl.flag(out, "output", "o", "output file", "file");
+
+    check(run(cl, {"t", "-ab"}).empty() && a == true && b == true, "-ab");
+    check(!run(cl, {"t", "-ao"}).empty(), "folding with a string flag");
+    check(!run(cl, {"t", "-oa"}).empty(), "folding on a string flag");
+    check(!run(cl, {"t", "-ax"}).empty(), "folding with an unknown flag");
+}
+
+void terminator()
+{
+    auto verbose = std::optional<bool>{};
+    auto files = std::vector<std::string>{};
+    auto cl = cli::app{"terminator"};
+    cl.flag(verbose, "verbose", "v", "verbose");
+    cl.arg({files, false}, "FILES", "files");
+    check(run(cl, {"t", "a", "--", "-v", "--", "b"}).empty(), "'--' ends flags");
+    check(!verbose && files == std::vector<std::string>{"a", "-v", "--", "b"},
+        "tail is positional");
+
+    auto cmd = std::string{};
+    auto tail = cli::passthrough{};
+    auto pt = cli::app{"passthrough"};
+    pt.flag(verbose, "verbose", "v", "verbose");
+    pt.arg(cmd, "CMD", "command");
+    pt.arg(tail, "ARGS", "arguments");
+    auto seen = std::vector<std::string_view>{};
+    pt.action = [&]() { seen.assign(tail.begin(), tail.end()); };
+    check(run(pt, {"t", "-v", "run", "--", "sh", "-c", "x"}).empty(), "passthrough");
+    check(cmd == "run" && seen == std::vector<std::string_view>{"sh", "-c", "x"},
+        "passthrough tail");
+    check(!run(pt, {"t", "run", "extra"}).empty(), "arguments before '--'");
+}
+
+void duplicate_policies()
+{
+    auto parse = [](cli::duplicates policy, std::string& err) -> std::string {
+        auto defines = cli::key_value_map{policy};
+        auto cl = cli::app{"duplicates"};
+        cl.flag(defines, "define", "D", "define a macro", "key=value");
+        err = run(cl, {"t", "-DK=1", "-DX", "-DK=2"});
+        return std::string{defines.find("K").value_or("")};
+    };
+    auto err = std::string{};
+    check(parse(cli::duplicates::last_wins, err) == "2" && err.empty(), "last_wins");
+    check(parse(cli::duplicates::first_wins, err) == "1" && err.empty(), "first_wins");
+    parse(cli::duplicates::error, err);
+    check(err.find("duplicate definition: K") != std::string::npos, "duplicates::error");
+
+    // pairs from an earlier run are not merged into the next one
+    auto strict = cli::key_value_map{cli::duplicates::error};
+    auto defines = cli::key_value_map{};
+    auto cl = cli::app{"reruns"};
+    cl.flag(strict, "strict", "S", "strict definition", "key=value");
+    cl.flag(defines, "define", "D", "define a macro", "key=value");
+    check(run(cl, {"t", "-SK=1", "-DA=1"}).empty(), "first run");
+    check(run(cl, {"t", "-SK=1", "-DB=1"}).empty(), "second run");
+    check(strict.size() == 1 && defines.size() == 1 && defines.contains("B") &&
+              !defines.contains("A"),
+        "maps are reset between runs");
+}
+
+void choices()
+{
+    enum class format { json, csv, table };
+    static constexpr auto formats = cli::make_choices<format>(
+        {{"json", format::json}, {"csv", format::csv}, {"table", format::table}});
+    auto fmt = cli::choice<format>{formats, format::table};
+    auto cl = cli::app{"choices"};
+    cl.flag(fmt, "format", "f", "output format");
+    check(run(cl, {"t"}).empty() && fmt.value == format::table, "initial choice");
+    check(run(cl, {"t", "--format=csv"}).empty() && fmt.value == format::csv, "valid choice");
+    check(run(cl, {"t", "-f", "xml"}) == "invalid value 'xml', expected one of: json, csv, table",
+        "invalid choice");
+}
+
+void lazy_reruns()
+{
+    auto name = cli::lazy<std::string>{};
+    auto cl = cli::app{"lazy"};
+    cl.flag(name, "name", "", "name", "value");
+    auto seen = std::string{};
+    cl.action = [&]() { seen = name.get(); };
+    run(cl, {"t", "--name=first"});
+    run(cl, {"t", "--name=second"});
+    check(seen == "second", "lazy values are not cached across runs");
+}
+
+void streams()
+{
+    // items that span several blocks of the stream buffer
+    auto fn = std::filesystem::temp_directory_path() / "clixx-test-stream.txt";
+    auto expected = std::vector<std::string>{"a", std::string(100, 'x'), "bc", "", "d\r"};
+    {
+        auto f = std::ofstream{fn, std::ios::binary};
+        for (auto& s : expected)
+            f << s << '\0';
+        f << "tail";
+    }
+    expected = {"first", "a", std::string(100, 'x'), "bc", "d\r", "tail", "last"};
+
+    auto items = cli::arg_stream{'\0', 8};
+    auto cl = cli::app{"streams"};
+    cl.arg(items, "ITEMS", "items");
+    auto seen = std::vector<std::string>{};
+    cl.action = [&]() {
+        for (auto item : items)
+            seen.emplace_back(item);
+    };
+    auto at_file = "@" + fn.string();
+    check(run(cl, {"t", "first", at_file, "last"}).empty(), "stream from a file");
+    check(seen == expected, "stream items");
+    check(!run(cl, {"t", "@does-not-exist"}).empty(), "missing stream file");
+
+    // a partially consumed stream does not leak into the next run
+    auto first = std::string{};
+    auto partial = cli::app{"partial"};
+    partial.arg(items, "ITEMS", "items");
+    partial.action = [&]() {
+        auto it = items.begin();
+        first = it != items.end() ? std::string{*it} : std::string{};
+    };
+    check(run(partial, {"t", at_file, "x"}).empty() && first == "a", "partial read");
+    check(run(partial, {"t", "c"}).empty() && first == "c" && items.raw_list().size() == 1,
+        "streams are reset");
+    std::filesystem::remove(fn);
+}
+
+void paths()
+{
+    namespace fs = std::filesystem;
+    auto dir = fs::temp_directory_path() / "clixx-test-paths";
+    fs::create_directories(dir);
+    auto file = dir / "file.txt";
+    std::ofstream{file} << "x";
+
+    auto inputs = cli::path_list{cli::path_check::file};
+    auto outdir = cli::path_list{cli::path_check::directory};
+    auto cl = cli::app{"paths"};
+    cl.flag({outdir, false}, "output", "o", "output directory", "dir");
+    cl.arg(inputs, "FILES", "input files");
+
+    check(run(cl, {"t", "-o", dir.string(), file.string()}).empty(), "valid paths");
+    check(inputs.items.size() == 1 && outdir.items.size() == 1, "paths of a single run");
+
+    // every failed check is reported in a single error
+    auto missing = (dir / "missing.txt").string();
+    auto err = run(cl, {"t", "-o", file.string(), dir.string(), missing, file.string()});
+    check(err == "invalid paths:\n    " + dir.string() + ": not a file\n    " + missing +
+                     ": does not exist\n    " + file.string() + ": not a directory",
+        "aggregated path errors");
+
+    // a path from an earlier run is not checked again
+    auto removed = dir / "removed.txt";
+    std::ofstream{removed} << "x";
+    run(cl, {"t", removed.string()});
+    fs::remove(removed);
+    check(run(cl, {"t", file.string()}).empty() && inputs.items.size() == 1, "paths are reset");
+    fs::remove_all(dir);
+}
+
+void batches()
+{
+    auto b = cli::batch{"tool", "batch", [](cli::app& a, std::ostream& out) {
+        auto& args = a.make<std::vector<std::string>>();
+        a.arg({args, false}, "ARGS", "arguments");
+        a.action = [&]() {
+            for (auto& s : args)
+                out << s << ';';
+        };
+    }};
+    auto results = b.execute({"tool", "a", ",", "b", "--", "x", ",", "y"});
+    check(results.size() == 2 && results[0].output == "a;" && results[1].output == "b;x;,;y;",
+        "batch split stops at '--'");
+}
+
+} // namespace
+
+auto main() -> int
+{
+    attached_values();
+    foldings();
+    terminator();
+    duplicate_policies();
+    choices();
+    lazy_reruns();
+    streams();
+    paths();
+    batches();
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
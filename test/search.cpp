@@ -0,0 +1,128 @@
+#include "../cli++.hpp"
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+auto failed = 0;
+
+void check(bool ok, char const* what)
+{
+    if (!ok) {
+        printf("failed: %s\n", what);
+        ++failed;
+    }
+}
+
+// runs the command line, returns the help message
+auto run(cli::app& cl, std::initializer_list<std::string_view> cmdline) -> std::string
+{
+    try {
+        cl.execute(cmdline);
+    }
+    catch (cli::help const& e) {
+        return e.what();
+    }
+    catch (cli::error const& e) {
+        return std::string{"error: "} + e.what();
+    }
+    return {};
+}
+
+void setup(cli::app& a, char const* sub, char const* desc)
+{
+    a.subcommand(sub, desc, [](cli::command&) {});
+}
+
+auto found(std::string const& msg, char const* what) -> bool
+{
+    return msg.find("no commands found") == std::string::npos &&
+           msg.find(what) != std::string::npos;
+}
+
+void round_trip()
+{
+    auto fn = std::filesystem::temp_directory_path() / "clixx-test.search-index";
+    std::filesystem::remove(fn);
+
+    auto idx = cli::search_index{};
+    auto id = idx.add_doc("frob", "frobnicate the widgets");
+    idx.add_text(id, "frobnicate the widgets", 1);
+    idx.add_doc("zap", "zap gadgets");
+    check(idx.save(fn, "build-1"), "save");
+
+    auto loaded = cli::search_index{};
+    check(!loaded.load(fn, "build-2"), "build id mismatch");
+    check(loaded.empty(), "index not replaced on mismatch");
+    check(loaded.load(fn, "build-1"), "load");
+    auto m = loaded.query("frob");
+    check(loaded.docs.size() == 2 && m.size() == 1 && loaded.docs[m[0].doc].path == "frob",
+        "loaded index");
+    std::filesystem::remove(fn);
+}
+
+void persisted()
+{
+    auto fn = std::filesystem::temp_directory_path() / "clixx-test-app.search-index";
+    std::filesystem::remove(fn);
+
+    auto a = cli::app{"alpha", "alpha tool"};
+    a.search_index_path = fn;
+    a.build_id = "1";
+    setup(a, "frob", "frobnicate the widgets");
+    check(found(run(a, {"t", "--help", "--search", "frobnicate"}), "frob"), "built index");
+    check(std::filesystem::exists(fn), "index saved");
+
+    // the persisted index is used while the build id matches
+    auto b = cli::app{"alpha", "alpha tool"};
+    b.search_index_path = fn;
+    b.build_id = "1";
+    setup(b, "zap", "zap gadgets");
+    check(found(run(b, {"t", "--help", "--search", "frobnicate"}), "frob"), "loaded index");
+
+    // and rebuilt when it does not
+    b.build_id = "2";
+    check(found(run(b, {"t", "--help", "--search", "gadgets"}), "zap"), "rebuilt index");
+
+    // another tool of the same binary does not pick up this index
+    auto c = cli::app{"multi beta", "beta tool"};
+    c.search_index_path = fn;
+    c.build_id = "2";
+    setup(c, "zip", "zip gizmos");
+    check(found(run(c, {"t", "--help", "--search", "gizmos"}), "zip"), "index per tool");
+    std::filesystem::remove(fn);
+}
+
+void default_location()
+{
+    // tools of a multicall binary keep separate indexes next to it
+    auto exe = cli::internal::executable_file({});
+    auto alpha_fn = exe;
+    alpha_fn += ".alpha.search-index";
+    auto beta_fn = exe;
+    beta_fn += ".beta.search-index";
+
+    auto alpha = cli::app{"alpha", "alpha tool"};
+    setup(alpha, "frob", "frobnicate the widgets");
+    check(found(run(alpha, {"multi", "--help", "--search", "frobnicate"}), "frob"), "alpha");
+
+    auto beta = cli::app{"multi beta", "beta tool"};
+    setup(beta, "zap", "zap gadgets");
+    check(found(run(beta, {"multi", "--help", "--search", "gadgets"}), "zap"), "beta");
+    check(std::filesystem::exists(alpha_fn) && std::filesystem::exists(beta_fn),
+        "index file names");
+    std::filesystem::remove(alpha_fn);
+    std::filesystem::remove(beta_fn);
+}
+
+} // namespace
+
+auto main() -> int
+{
+    round_trip();
+    persisted();
+    default_location();
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}